@@ -0,0 +1,64 @@
+#pragma once
+#include <map>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+template <typename Key, typename Value>
+class ConcurrentMap {
+public:
+    static_assert(std::is_integral_v<Key>, "ConcurrentMap supports only integer keys");
+
+    struct Access {
+        std::lock_guard<std::mutex> guard;
+        Value& ref_to_value;
+    };
+
+    explicit ConcurrentMap(size_t bucket_count);
+
+    Access operator[](const Key& key);
+    void Erase(const Key& key);
+    std::map<Key, Value> BuildOrdinaryMap();
+
+private:
+    struct Bucket {
+        std::mutex mutex;
+        std::map<Key, Value> map;
+    };
+
+    std::vector<Bucket> buckets_;
+
+    Bucket& GetBucket(const Key& key);
+};
+
+template <typename Key, typename Value>
+ConcurrentMap<Key, Value>::ConcurrentMap(size_t bucket_count) : buckets_(bucket_count) {}
+
+template <typename Key, typename Value>
+typename ConcurrentMap<Key, Value>::Access ConcurrentMap<Key, Value>::operator[](const Key& key) {
+    Bucket& bucket = GetBucket(key);
+    return { std::lock_guard(bucket.mutex), bucket.map[key] };
+}
+
+template <typename Key, typename Value>
+void ConcurrentMap<Key, Value>::Erase(const Key& key) {
+    Bucket& bucket = GetBucket(key);
+    std::lock_guard guard(bucket.mutex);
+    bucket.map.erase(key);
+}
+
+template <typename Key, typename Value>
+std::map<Key, Value> ConcurrentMap<Key, Value>::BuildOrdinaryMap() {
+    std::map<Key, Value> result;
+    for (Bucket& bucket : buckets_) {
+        std::lock_guard guard(bucket.mutex);
+        result.insert(bucket.map.begin(), bucket.map.end());
+    }
+    return result;
+}
+
+template <typename Key, typename Value>
+typename ConcurrentMap<Key, Value>::Bucket& ConcurrentMap<Key, Value>::GetBucket(const Key& key) {
+    return buckets_[static_cast<uint64_t>(key) % buckets_.size()];
+}
@@ -0,0 +1,54 @@
+#include <algorithm>
+
+#include "dense_accumulator.h"
+
+using namespace std;
+
+DenseAccumulator::Lease::Lease(DenseAccumulator& accumulator, size_t id_limit)
+    : accumulator_(accumulator) {
+    accumulator_.Reset(id_limit);
+}
+
+DenseAccumulator::Lease::~Lease() {
+    accumulator_.Clear();
+}
+
+void DenseAccumulator::Reset(size_t id_limit) {
+    if (relevances_.size() < id_limit) {
+        relevances_.resize(id_limit, 0.0);
+    }
+    if (is_touched_.size() < id_limit) {
+        is_touched_.resize(id_limit, 0);
+    }
+    is_in_use_ = true;
+}
+
+void DenseAccumulator::Add(int document_id, double relevance) {
+    if (!is_touched_[document_id]) {
+        is_touched_[document_id] = 1;
+        touched_.push_back(document_id);
+    }
+    relevances_[document_id] += relevance;
+}
+
+double DenseAccumulator::Get(int document_id) const {
+    return relevances_[document_id];
+}
+
+const vector<int>& DenseAccumulator::GetSortedTouched() {
+    sort(touched_.begin(), touched_.end());
+    return touched_;
+}
+
+void DenseAccumulator::Clear() {
+    for (const int document_id : touched_) {
+        relevances_[document_id] = 0.0;
+        is_touched_[document_id] = 0;
+    }
+    touched_.clear();
+    is_in_use_ = false;
+}
+
+bool DenseAccumulator::IsInUse() const {
+    return is_in_use_;
+}
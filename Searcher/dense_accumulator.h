@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Relevance accumulator indexed directly by document id. Only the slots that
+// were touched by the last query are cleared, so the buffers are reused across
+// queries without reallocation once they have grown to the id range.
+class DenseAccumulator {
+public:
+    // Holds the accumulator for one query and clears it when destroyed, so an
+    // exception thrown mid-query doesn't leave it marked as in use.
+    class Lease {
+    public:
+        Lease(DenseAccumulator& accumulator, size_t id_limit);
+        ~Lease();
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+    private:
+        DenseAccumulator& accumulator_;
+    };
+
+    void Add(int document_id, double relevance);
+    double Get(int document_id) const;
+    const std::vector<int>& GetSortedTouched();
+
+    bool IsInUse() const;
+
+private:
+    std::vector<double> relevances_;
+    std::vector<uint8_t> is_touched_;
+    std::vector<int> touched_;
+    bool is_in_use_ = false;
+
+    void Reset(size_t id_limit);
+    void Clear();
+};
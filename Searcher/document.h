@@ -1,5 +1,7 @@
 #pragma once
 #include<iostream>
+#include<string_view>
+#include<vector>
 
 struct Document {
     Document() = default;
@@ -17,6 +19,13 @@ enum class DocumentStatus {
     REMOVED
 };
 
+struct NewDocument {
+    int id = 0;
+    std::string_view text;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+};
+
 void PrintDocument(const Document& document);
 
 std::ostream& operator << (std::ostream& output, const Document& doc);
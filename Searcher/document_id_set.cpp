@@ -0,0 +1,96 @@
+#include <algorithm>
+
+#include "document_id_set.h"
+
+using namespace std;
+
+namespace {
+
+const size_t BITMAP_WORD_COUNT = (1 << 16) / 64;
+
+}
+
+DocumentIdSet::DocumentIdSet(pmr::memory_resource* resource)
+    : chunks_(resource) {
+}
+
+void DocumentIdSet::Insert(int document_id) {
+    const uint32_t key = static_cast<uint32_t>(document_id) >> 16;
+    const uint16_t value = static_cast<uint16_t>(document_id);
+
+    auto chunk = chunks_.end();
+    if (chunks_.empty() || chunks_.back().key < key) {
+        chunk = chunks_.insert(chunks_.end(), MakeChunk(key));
+    }
+    else {
+        chunk = lower_bound(chunks_.begin(), chunks_.end(), key,
+            [](const Chunk& lhs, uint32_t rhs) {
+                return lhs.key < rhs;
+            });
+        if (chunk->key != key) {
+            chunk = chunks_.insert(chunk, MakeChunk(key));
+        }
+    }
+
+    if (!chunk->bits.empty()) {
+        uint64_t& word = chunk->bits[value / 64];
+        const uint64_t mask = uint64_t{ 1 } << (value % 64);
+        if (!(word & mask)) {
+            word |= mask;
+            ++size_;
+        }
+        return;
+    }
+
+    const auto it = lower_bound(chunk->values.begin(), chunk->values.end(), value);
+    if (it != chunk->values.end() && *it == value) {
+        return;
+    }
+    chunk->values.insert(it, value);
+    ++size_;
+    if (chunk->values.size() > ARRAY_LIMIT) {
+        ConvertToBitmap(*chunk);
+    }
+}
+
+bool DocumentIdSet::Contains(int document_id) const {
+    const Chunk* chunk = FindChunk(static_cast<uint32_t>(document_id) >> 16);
+    if (chunk == nullptr) {
+        return false;
+    }
+    const uint16_t value = static_cast<uint16_t>(document_id);
+    if (!chunk->bits.empty()) {
+        return (chunk->bits[value / 64] >> (value % 64)) & 1;
+    }
+    return binary_search(chunk->values.begin(), chunk->values.end(), value);
+}
+
+size_t DocumentIdSet::size() const {
+    return size_;
+}
+
+bool DocumentIdSet::empty() const {
+    return size_ == 0;
+}
+
+DocumentIdSet::Chunk DocumentIdSet::MakeChunk(uint32_t key) const {
+    pmr::memory_resource* resource = chunks_.get_allocator().resource();
+    return { key, pmr::vector<uint16_t>(resource), pmr::vector<uint64_t>(resource) };
+}
+
+const DocumentIdSet::Chunk* DocumentIdSet::FindChunk(uint32_t key) const {
+    const auto it = lower_bound(chunks_.begin(), chunks_.end(), key,
+        [](const Chunk& lhs, uint32_t rhs) {
+            return lhs.key < rhs;
+        });
+    return it != chunks_.end() && it->key == key ? &*it : nullptr;
+}
+
+void DocumentIdSet::ConvertToBitmap(Chunk& chunk) {
+    chunk.bits.assign(BITMAP_WORD_COUNT, 0);
+    for (const uint16_t value : chunk.values) {
+        chunk.bits[value / 64] |= uint64_t{ 1 } << (value % 64);
+    }
+    chunk.values.clear();
+    chunk.values.shrink_to_fit();
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+// Set of non-negative document ids split into 2^16-wide chunks. A chunk keeps
+// a sorted array of low halves until it grows past ARRAY_LIMIT entries and is
+// then switched to a fixed-size bitmap.
+class DocumentIdSet {
+public:
+    static const size_t ARRAY_LIMIT = 4096;
+
+    explicit DocumentIdSet(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    void Insert(int document_id);
+    bool Contains(int document_id) const;
+
+    size_t size() const;
+    bool empty() const;
+
+private:
+    struct Chunk {
+        uint32_t key = 0;
+        std::pmr::vector<uint16_t> values;
+        std::pmr::vector<uint64_t> bits;
+    };
+
+    std::pmr::vector<Chunk> chunks_;
+    size_t size_ = 0;
+
+    Chunk MakeChunk(uint32_t key) const;
+    const Chunk* FindChunk(uint32_t key) const;
+    static void ConvertToBitmap(Chunk& chunk);
+};
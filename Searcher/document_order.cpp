@@ -0,0 +1,53 @@
+#include <stdexcept>
+
+#include "document_order.h"
+
+using namespace std;
+
+DocumentOrder::DocumentOrder(const DocumentOrder& other) {
+    lock_guard guard(other.mutex_);
+    document_numbers_ = other.document_numbers_;
+    is_removed_ = other.is_removed_;
+    removed_count_ = other.removed_count_;
+}
+
+DocumentOrder& DocumentOrder::operator=(const DocumentOrder& other) {
+    if (this != &other) {
+        DocumentOrder copy(other);
+        lock_guard guard(mutex_);
+        document_numbers_ = move(copy.document_numbers_);
+        is_removed_ = move(copy.is_removed_);
+        removed_count_ = copy.removed_count_;
+    }
+    return *this;
+}
+
+void DocumentOrder::Add(int document_number) {
+    const size_t number = static_cast<size_t>(document_number);
+    if (is_removed_.size() <= number) {
+        is_removed_.resize(number + 1, 1);
+    }
+    is_removed_[number] = 0;
+    document_numbers_.push_back(document_number);
+}
+
+void DocumentOrder::Remove(int document_number) {
+    is_removed_.at(static_cast<size_t>(document_number)) = 1;
+    ++removed_count_;
+}
+
+int DocumentOrder::GetDocumentNumber(size_t index) const {
+    lock_guard guard(mutex_);
+    if (removed_count_ > 0) {
+        erase_if(document_numbers_, [this](int document_number) {
+            return is_removed_[static_cast<size_t>(document_number)] != 0;
+        });
+        removed_count_ = 0;
+    }
+    return document_numbers_.at(index);
+}
+
+size_t DocumentOrder::size() const {
+    lock_guard guard(mutex_);
+    return document_numbers_.size() - removed_count_;
+}
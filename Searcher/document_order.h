@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Internal numbers of live documents in the order they were added. Removing a
+// document only marks its number; the order is compacted by the next
+// positional lookup, so both are O(1) amortised. Lookups may run concurrently.
+class DocumentOrder {
+public:
+    DocumentOrder() = default;
+    DocumentOrder(const DocumentOrder& other);
+    DocumentOrder& operator=(const DocumentOrder& other);
+
+    void Add(int document_number);
+    void Remove(int document_number);
+
+    int GetDocumentNumber(size_t index) const;
+    size_t size() const;
+
+private:
+    mutable std::mutex mutex_;
+    mutable std::vector<int> document_numbers_;
+    std::vector<uint8_t> is_removed_;
+    mutable size_t removed_count_ = 0;
+};
@@ -0,0 +1,96 @@
+#include "index_snapshot.h"
+
+using namespace std;
+
+SnapshotWriter::SnapshotWriter(const string& path) : output_(path, ios::binary | ios::trunc) {
+    if (!output_) {
+        throw runtime_error("Can't create file "s + path);
+    }
+    WriteBytes(INDEX_SNAPSHOT_MAGIC, sizeof(INDEX_SNAPSHOT_MAGIC));
+    Write(INDEX_SNAPSHOT_VERSION);
+    Align();
+}
+
+void SnapshotWriter::WriteStrings(const vector<string_view>& strings) {
+    vector<uint64_t> offsets;
+    offsets.reserve(strings.size() + 1);
+    uint64_t offset = 0;
+    for (const string_view str : strings) {
+        offsets.push_back(offset);
+        offset += str.size();
+    }
+    offsets.push_back(offset);
+
+    WriteArray(offsets);
+    Write(offset);
+    for (const string_view str : strings) {
+        WriteBytes(str.data(), str.size());
+    }
+    Align();
+}
+
+void SnapshotWriter::Finish() {
+    output_.flush();
+    if (!output_) {
+        throw runtime_error("Can't write index snapshot"s);
+    }
+}
+
+void SnapshotWriter::WriteBytes(const void* data, size_t size) {
+    output_.write(static_cast<const char*>(data), static_cast<streamsize>(size));
+    offset_ += size;
+}
+
+void SnapshotWriter::Align() {
+    static const char zeros[INDEX_SNAPSHOT_ALIGNMENT] = {};
+    const size_t padding = (INDEX_SNAPSHOT_ALIGNMENT - offset_ % INDEX_SNAPSHOT_ALIGNMENT) % INDEX_SNAPSHOT_ALIGNMENT;
+    WriteBytes(zeros, padding);
+}
+
+SnapshotReader::SnapshotReader(const string& path) : file_(path) {
+    if (file_.size() < sizeof(INDEX_SNAPSHOT_MAGIC)
+        || memcmp(file_.data(), INDEX_SNAPSHOT_MAGIC, sizeof(INDEX_SNAPSHOT_MAGIC)) != 0) {
+        throw runtime_error("File "s + path + " is not an index snapshot"s);
+    }
+    offset_ = sizeof(INDEX_SNAPSHOT_MAGIC);
+    if (Read<uint32_t>() != INDEX_SNAPSHOT_VERSION) {
+        throw runtime_error("Unsupported index snapshot version"s);
+    }
+    Align();
+}
+
+vector<string_view> SnapshotReader::ReadStrings() {
+    const span<const uint64_t> offsets = ReadArray<uint64_t>();
+    const uint64_t chars_count = Read<uint64_t>();
+    const char* chars = ReadBytes(chars_count);
+    Align();
+
+    vector<string_view> strings;
+    if (offsets.empty()) {
+        return strings;
+    }
+    strings.reserve(offsets.size() - 1);
+    for (size_t i = 0; i + 1 < offsets.size(); ++i) {
+        if (offsets[i] > offsets[i + 1] || offsets[i + 1] > chars_count) {
+            throw runtime_error("Index snapshot is corrupted"s);
+        }
+        strings.emplace_back(chars + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+    return strings;
+}
+
+const char* SnapshotReader::ReadBytes(size_t size) {
+    if (size > file_.size() - offset_) {
+        throw runtime_error("Index snapshot is corrupted"s);
+    }
+    const char* data = file_.data() + offset_;
+    offset_ += size;
+    return data;
+}
+
+void SnapshotReader::Align() {
+    offset_ += (INDEX_SNAPSHOT_ALIGNMENT - offset_ % INDEX_SNAPSHOT_ALIGNMENT) % INDEX_SNAPSHOT_ALIGNMENT;
+    if (offset_ > file_.size()) {
+        offset_ = file_.size();
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdexcept>
+#include <type_traits>
+
+#include "mapped_file.h"
+
+const char INDEX_SNAPSHOT_MAGIC[8] = { 'Y', 'P', 'S', 'I', 'N', 'D', 'E', 'X' };
+const uint32_t INDEX_SNAPSHOT_VERSION = 5;
+const size_t INDEX_SNAPSHOT_ALIGNMENT = 8;
+
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(const std::string& path);
+
+    template <typename T>
+    void Write(const T& value);
+
+    template <typename T>
+    void WriteArray(const T* values, size_t count);
+
+    template <typename T>
+    void WriteArray(const std::vector<T>& values);
+
+    void WriteStrings(const std::vector<std::string_view>& strings);
+    void Finish();
+
+private:
+    std::ofstream output_;
+    uint64_t offset_ = 0;
+
+    void WriteBytes(const void* data, size_t size);
+    void Align();
+};
+
+class SnapshotReader {
+public:
+    explicit SnapshotReader(const std::string& path);
+
+    template <typename T>
+    T Read();
+
+    template <typename T>
+    std::span<const T> ReadArray();
+
+    std::vector<std::string_view> ReadStrings();
+
+private:
+    MappedFile file_;
+    size_t offset_ = 0;
+
+    const char* ReadBytes(size_t size);
+    void Align();
+};
+
+template <typename T>
+void SnapshotWriter::Write(const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    WriteBytes(&value, sizeof(T));
+}
+
+template <typename T>
+void SnapshotWriter::WriteArray(const T* values, size_t count) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    Write(static_cast<uint64_t>(count));
+    Align();
+    WriteBytes(values, count * sizeof(T));
+    Align();
+}
+
+template <typename T>
+void SnapshotWriter::WriteArray(const std::vector<T>& values) {
+    WriteArray(values.data(), values.size());
+}
+
+template <typename T>
+T SnapshotReader::Read() {
+    static_assert(std::is_trivially_copyable_v<T>);
+    T value;
+    std::memcpy(&value, ReadBytes(sizeof(T)), sizeof(T));
+    return value;
+}
+
+template <typename T>
+std::span<const T> SnapshotReader::ReadArray() {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const uint64_t count = Read<uint64_t>();
+    if (count > file_.size() / sizeof(T)) {
+        throw std::runtime_error("Index snapshot is corrupted");
+    }
+    Align();
+    const T* values = reinterpret_cast<const T*>(ReadBytes(count * sizeof(T)));
+    Align();
+    return { values, static_cast<size_t>(count) };
+}
@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <array>
+#include <map>
+#include <cmath>
+
+#include "inverted_index.h"
+#include "index_snapshot.h"
+
+using namespace std;
+
+InvertedIndex::InvertedIndex(const InvertedIndex& other)
+    : terms_(other.terms_)
+    , postings_(other.postings_)
+    , log_document_freqs_(other.log_document_freqs_)
+    , has_positions_(other.has_positions_)
+    , positions_(other.positions_) {
+    term_to_id_.reserve(terms_.size());
+    for (size_t term_id = 0; term_id < terms_.size(); ++term_id) {
+        term_to_id_.emplace(terms_[term_id], static_cast<int>(term_id));
+    }
+}
+
+InvertedIndex& InvertedIndex::operator=(const InvertedIndex& other) {
+    if (this != &other) {
+        *this = InvertedIndex(other);
+    }
+    return *this;
+}
+
+int InvertedIndex::AddTerm(string_view word) {
+    const auto it = term_to_id_.find(word);
+    if (it != term_to_id_.end()) {
+        return it->second;
+    }
+
+    const int term_id = static_cast<int>(terms_.size());
+    terms_.emplace_back(word);
+    postings_.emplace_back();
+    if (has_positions_) {
+        positions_.emplace_back();
+    }
+    log_document_freqs_.push_back(log(0.0));
+    term_to_id_.emplace(terms_.back(), term_id);
+    return term_id;
+}
+
+int InvertedIndex::FindTerm(string_view word) const {
+    const auto it = term_to_id_.find(word);
+    return it == term_to_id_.end() ? NO_TERM : it->second;
+}
+
+const string& InvertedIndex::GetTerm(int term_id) const {
+    return terms_.at(term_id);
+}
+
+size_t InvertedIndex::GetTermCount() const {
+    return terms_.size();
+}
+
+void InvertedIndex::AddPosting(int term_id, int document_id, uint32_t term_count, uint32_t document_length) {
+    postings_.at(term_id).Add(document_id, term_count, document_length);
+    UpdateLogDocumentFreq(term_id);
+}
+
+void InvertedIndex::RemovePosting(int term_id, int document_id) {
+    if (postings_.at(term_id).Remove(document_id)) {
+        UpdateLogDocumentFreq(term_id);
+    }
+    if (has_positions_) {
+        positions_[term_id].erase(document_id);
+    }
+}
+
+const PostingList& InvertedIndex::GetPostings(int term_id) const {
+    return postings_.at(term_id);
+}
+
+double InvertedIndex::GetLogDocumentFreq(int term_id) const {
+    return log_document_freqs_[term_id];
+}
+
+bool InvertedIndex::ContainsDocument(int term_id, int document_id) const {
+    return postings_.at(term_id).Contains(document_id);
+}
+
+void InvertedIndex::EnablePositions() {
+    has_positions_ = true;
+    positions_.resize(terms_.size());
+}
+
+bool InvertedIndex::HasPositions() const {
+    return has_positions_;
+}
+
+void InvertedIndex::AddPositions(int term_id, int document_id, vector<uint32_t> positions) {
+    positions_.at(term_id)[document_id] = move(positions);
+}
+
+const vector<uint32_t>* InvertedIndex::FindPositions(int term_id, int document_id) const {
+    if (!has_positions_) {
+        return nullptr;
+    }
+    const auto& document_positions = positions_.at(term_id);
+    const auto it = document_positions.find(document_id);
+    return it == document_positions.end() ? nullptr : &it->second;
+}
+
+void InvertedIndex::Save(SnapshotWriter& writer) const {
+    writer.WriteStrings(vector<string_view>(terms_.begin(), terms_.end()));
+
+    vector<uint64_t> offsets;
+    vector<int32_t> document_ids;
+    vector<uint32_t> term_counts;
+    vector<uint32_t> document_lengths;
+    offsets.reserve(postings_.size() + 1);
+    array<RawPosting, PostingList::MAX_BLOCK_SIZE> buffer;
+    for (const PostingList& postings : postings_) {
+        offsets.push_back(document_ids.size());
+        for (size_t block = 0; block < postings.GetBlockCount(); ++block) {
+            const size_t count = postings.DecodeBlock(block, buffer.data());
+            for (size_t i = 0; i < count; ++i) {
+                document_ids.push_back(buffer[i].document_id);
+                term_counts.push_back(buffer[i].term_count);
+                document_lengths.push_back(buffer[i].document_length);
+            }
+        }
+    }
+    offsets.push_back(document_ids.size());
+
+    writer.WriteArray(offsets);
+    writer.WriteArray(document_ids);
+    writer.WriteArray(term_counts);
+    writer.WriteArray(document_lengths);
+
+    vector<uint64_t> entry_offsets;
+    vector<int32_t> entry_document_ids;
+    vector<uint64_t> position_offsets;
+    vector<uint32_t> positions;
+    for (const auto& document_positions : positions_) {
+        entry_offsets.push_back(entry_document_ids.size());
+        map<int, const vector<uint32_t>*> sorted_positions;
+        for (const auto& [document_id, term_positions] : document_positions) {
+            sorted_positions[document_id] = &term_positions;
+        }
+        for (const auto& [document_id, term_positions] : sorted_positions) {
+            entry_document_ids.push_back(document_id);
+            position_offsets.push_back(positions.size());
+            positions.insert(positions.end(), term_positions->begin(), term_positions->end());
+        }
+    }
+    entry_offsets.push_back(entry_document_ids.size());
+    position_offsets.push_back(positions.size());
+
+    writer.Write<uint32_t>(has_positions_ ? 1 : 0);
+    writer.WriteArray(entry_offsets);
+    writer.WriteArray(entry_document_ids);
+    writer.WriteArray(position_offsets);
+    writer.WriteArray(positions);
+}
+
+void InvertedIndex::Load(SnapshotReader& reader) {
+    const vector<string_view> terms = reader.ReadStrings();
+    const auto offsets = reader.ReadArray<uint64_t>();
+    const auto document_ids = reader.ReadArray<int32_t>();
+    const auto term_counts = reader.ReadArray<uint32_t>();
+    const auto document_lengths = reader.ReadArray<uint32_t>();
+    if (offsets.size() != terms.size() + 1
+        || document_ids.size() != term_counts.size()
+        || document_ids.size() != document_lengths.size()
+        || offsets.back() != document_ids.size()) {
+        throw invalid_argument("Index snapshot is corrupted"s);
+    }
+
+    InvertedIndex index;
+    for (size_t term_id = 0; term_id < terms.size(); ++term_id) {
+        if (index.AddTerm(terms[term_id]) != static_cast<int>(term_id) || offsets[term_id] > offsets[term_id + 1]) {
+            throw invalid_argument("Index snapshot is corrupted"s);
+        }
+        PostingList& postings = index.postings_[term_id];
+        for (uint64_t i = offsets[term_id]; i < offsets[term_id + 1]; ++i) {
+            // Encoded gaps are differences of neighbouring document numbers, so
+            // they have to be non-negative and strictly increasing.
+            if (term_counts[i] == 0 || document_lengths[i] == 0 || document_ids[i] < 0
+                || (i > offsets[term_id] && document_ids[i] <= document_ids[i - 1])) {
+                throw invalid_argument("Index snapshot is corrupted"s);
+            }
+            postings.Add(document_ids[i], term_counts[i], document_lengths[i]);
+        }
+        index.UpdateLogDocumentFreq(static_cast<int>(term_id));
+    }
+
+    const bool has_positions = reader.Read<uint32_t>() != 0;
+    const auto entry_offsets = reader.ReadArray<uint64_t>();
+    const auto entry_document_ids = reader.ReadArray<int32_t>();
+    const auto position_offsets = reader.ReadArray<uint64_t>();
+    const auto positions = reader.ReadArray<uint32_t>();
+    if (has_positions) {
+        index.EnablePositions();
+        if (entry_offsets.size() != terms.size() + 1
+            || entry_offsets.back() != entry_document_ids.size()
+            || position_offsets.size() != entry_document_ids.size() + 1
+            || position_offsets.back() != positions.size()) {
+            throw invalid_argument("Index snapshot is corrupted"s);
+        }
+        for (size_t term_id = 0; term_id < terms.size(); ++term_id) {
+            if (entry_offsets[term_id] > entry_offsets[term_id + 1] || entry_offsets[term_id + 1] > entry_document_ids.size()) {
+                throw invalid_argument("Index snapshot is corrupted"s);
+            }
+            for (uint64_t entry = entry_offsets[term_id]; entry < entry_offsets[term_id + 1]; ++entry) {
+                if (position_offsets[entry] > position_offsets[entry + 1] || position_offsets[entry + 1] > positions.size()
+                    || entry_document_ids[entry] < 0
+                    || (entry > entry_offsets[term_id] && entry_document_ids[entry] <= entry_document_ids[entry - 1])) {
+                    throw invalid_argument("Index snapshot is corrupted"s);
+                }
+                index.AddPositions(static_cast<int>(term_id), entry_document_ids[entry],
+                    vector<uint32_t>(positions.begin() + position_offsets[entry], positions.begin() + position_offsets[entry + 1]));
+            }
+        }
+    }
+    *this = move(index);
+}
+
+void InvertedIndex::UpdateLogDocumentFreq(int term_id) {
+    log_document_freqs_[term_id] = log(static_cast<double>(postings_[term_id].size()));
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+
+#include "posting_list.h"
+
+class SnapshotWriter;
+class SnapshotReader;
+
+class InvertedIndex {
+public:
+    static const int NO_TERM = -1;
+
+    InvertedIndex() = default;
+    // The term dictionary is keyed by views into terms_, so a copy rebuilds it
+    // over its own terms.
+    InvertedIndex(const InvertedIndex& other);
+    InvertedIndex& operator=(const InvertedIndex& other);
+    InvertedIndex(InvertedIndex&& other) = default;
+    InvertedIndex& operator=(InvertedIndex&& other) = default;
+
+    int AddTerm(std::string_view word);
+    int FindTerm(std::string_view word) const;
+    const std::string& GetTerm(int term_id) const;
+    size_t GetTermCount() const;
+
+    void AddPosting(int term_id, int document_id, uint32_t term_count, uint32_t document_length);
+    void RemovePosting(int term_id, int document_id);
+    const PostingList& GetPostings(int term_id) const;
+    double GetLogDocumentFreq(int term_id) const;
+    bool ContainsDocument(int term_id, int document_id) const;
+
+    void EnablePositions();
+    bool HasPositions() const;
+    void AddPositions(int term_id, int document_id, std::vector<uint32_t> positions);
+    const std::vector<uint32_t>* FindPositions(int term_id, int document_id) const;
+
+    void Save(SnapshotWriter& writer) const;
+    void Load(SnapshotReader& reader);
+
+private:
+    std::deque<std::string> terms_;
+    std::unordered_map<std::string_view, int> term_to_id_;
+    std::vector<PostingList> postings_;
+    std::vector<double> log_document_freqs_;
+    bool has_positions_ = false;
+    std::vector<std::unordered_map<int, std::vector<uint32_t>>> positions_;
+
+    void UpdateLogDocumentFreq(int term_id);
+};
@@ -0,0 +1,145 @@
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <limits>
+#include <memory_resource>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "document.h"
+#include "posting_list.h"
+
+struct ScoredTerm {
+    const PostingList* postings = nullptr;
+    double weight = 0.0;
+    double upper_bound = 0.0;
+};
+
+// Document-at-a-time MaxScore traversal. Terms are ordered by their upper
+// bound; the cheapest ones become non-essential once their summed bounds can't
+// beat the current k-th score, and they are only probed (with block-max bounds)
+// for candidates coming from the essential lists. Excluded and filtered-out
+// candidates are rejected before any non-essential list is probed. Terms are
+// reordered in place; working buffers are taken from the given resource.
+// Up to top_documents.size() best documents are written into top_documents,
+// most relevant first; returns how many were found.
+template <typename Scorer, typename DocumentFilter, typename Compare>
+size_t RetrieveTopDocuments(const Scorer& scorer, std::span<ScoredTerm> terms,
+    std::span<const PostingList* const> excluded_postings,
+    std::span<Document> top_documents, double tolerance,
+    DocumentFilter document_filter, Compare more_relevant,
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+
+    const size_t max_count = top_documents.size();
+    size_t count = 0;
+    if (max_count == 0) {
+        return count;
+    }
+
+    std::sort(terms.begin(), terms.end(), [](const ScoredTerm& lhs, const ScoredTerm& rhs) {
+        return lhs.upper_bound < rhs.upper_bound;
+    });
+    std::pmr::vector<double> bound_prefix(terms.size(), resource);
+    std::transform_inclusive_scan(terms.begin(), terms.end(), bound_prefix.begin(), std::plus<>(),
+        [](const ScoredTerm& term) { return term.upper_bound; });
+
+    std::pmr::vector<PostingCursor> cursors(resource);
+    cursors.reserve(terms.size());
+    for (const ScoredTerm& term : terms) {
+        cursors.emplace_back(*term.postings);
+    }
+    std::pmr::vector<double> block_bounds(terms.size(), 0.0, resource);
+    std::pmr::vector<PostingCursor> excluded_cursors(resource);
+    excluded_cursors.reserve(excluded_postings.size());
+    for (const PostingList* postings : excluded_postings) {
+        excluded_cursors.emplace_back(*postings);
+    }
+
+    size_t first_essential = 0;
+    double threshold = -std::numeric_limits<double>::infinity();
+
+    while (first_essential < terms.size()) {
+        int candidate = INT_MAX;
+        for (size_t i = first_essential; i < terms.size(); ++i) {
+            if (!cursors[i].IsEnd()) {
+                candidate = std::min(candidate, cursors[i].GetDocumentId());
+            }
+        }
+        if (candidate == INT_MAX) {
+            break;
+        }
+
+        double relevance = 0.0;
+        for (size_t i = first_essential; i < terms.size(); ++i) {
+            if (!cursors[i].IsEnd() && cursors[i].GetDocumentId() == candidate) {
+                const RawPosting& posting = cursors[i].GetPosting();
+                relevance += scorer.ComputeScore(terms[i].weight, posting.term_count, posting.document_length);
+                cursors[i].Next();
+            }
+        }
+
+        bool is_excluded = false;
+        for (size_t i = 0; i < excluded_cursors.size() && !is_excluded; ++i) {
+            is_excluded = excluded_cursors[i].Seek(candidate);
+        }
+        if (is_excluded) {
+            continue;
+        }
+
+        const std::optional<int> rating = document_filter(candidate);
+        if (!rating) {
+            continue;
+        }
+
+        double remaining_bound = 0.0;
+        for (size_t i = 0; i < first_essential; ++i) {
+            cursors[i].SkipBlocks(candidate);
+            block_bounds[i] = cursors[i].IsEnd() ? 0.0 : scorer.ComputeBlockBound(terms[i].weight, cursors[i].GetCurrentBlock());
+            remaining_bound += block_bounds[i];
+        }
+        if (relevance + remaining_bound < threshold) {
+            continue;
+        }
+
+        bool is_pruned = false;
+        for (size_t i = first_essential; i-- > 0;) {
+            remaining_bound -= block_bounds[i];
+            if (cursors[i].Seek(candidate)) {
+                const RawPosting& posting = cursors[i].GetPosting();
+                relevance += scorer.ComputeScore(terms[i].weight, posting.term_count, posting.document_length);
+            }
+            if (relevance + remaining_bound < threshold) {
+                is_pruned = true;
+                break;
+            }
+        }
+        if (is_pruned) {
+            continue;
+        }
+
+        const Document document{ candidate, relevance, *rating };
+        if (count < max_count) {
+            top_documents[count++] = document;
+            std::push_heap(top_documents.begin(), top_documents.begin() + count, more_relevant);
+        }
+        else if (more_relevant(document, top_documents.front())) {
+            std::pop_heap(top_documents.begin(), top_documents.end(), more_relevant);
+            top_documents.back() = document;
+            std::push_heap(top_documents.begin(), top_documents.end(), more_relevant);
+        }
+        else {
+            continue;
+        }
+        if (count == max_count) {
+            threshold = top_documents.front().relevance - tolerance;
+            while (first_essential < terms.size() && bound_prefix[first_essential] < threshold) {
+                ++first_essential;
+            }
+        }
+    }
+
+    std::sort_heap(top_documents.begin(), top_documents.begin() + count, more_relevant);
+    return count;
+}
@@ -0,0 +1,87 @@
+#include <algorithm>
+
+#include "positional_match.h"
+
+using namespace std;
+
+namespace {
+
+size_t GallopLowerBound(const vector<uint32_t>& values, size_t from, uint32_t target) {
+    size_t end = from;
+    size_t step = 1;
+    while (end < values.size() && values[end] < target) {
+        from = end + 1;
+        end += step;
+        step *= 2;
+    }
+    end = min(end, values.size());
+    return lower_bound(values.begin() + from, values.begin() + end, target) - values.begin();
+}
+
+}
+
+bool ContainsPhrase(span<const vector<uint32_t>* const> word_positions, pmr::memory_resource* resource) {
+    if (word_positions.empty()) {
+        return true;
+    }
+
+    const vector<uint32_t>& first_positions = *word_positions[0];
+    pmr::vector<size_t> cursors(word_positions.size(), 0, resource);
+    uint32_t start = 0;
+    while (true) {
+        cursors[0] = GallopLowerBound(first_positions, cursors[0], start);
+        if (cursors[0] == first_positions.size()) {
+            return false;
+        }
+        start = first_positions[cursors[0]];
+
+        bool is_matched = true;
+        for (size_t i = 1; i < word_positions.size(); ++i) {
+            const vector<uint32_t>& positions = *word_positions[i];
+            const uint32_t target = start + static_cast<uint32_t>(i);
+            cursors[i] = GallopLowerBound(positions, cursors[i], target);
+            if (cursors[i] == positions.size()) {
+                return false;
+            }
+            if (positions[cursors[i]] != target) {
+                start = positions[cursors[i]] - static_cast<uint32_t>(i);
+                is_matched = false;
+                break;
+            }
+        }
+        if (is_matched) {
+            return true;
+        }
+    }
+}
+
+bool ContainsNearPair(const vector<uint32_t>& lhs, const vector<uint32_t>& rhs, uint32_t max_distance) {
+    size_t lhs_index = 0;
+    size_t rhs_index = 0;
+    while (lhs_index < lhs.size() && rhs_index < rhs.size()) {
+        const uint32_t lhs_position = lhs[lhs_index];
+        const uint32_t rhs_position = rhs[rhs_index];
+        if (lhs_position < rhs_position) {
+            if (rhs_position - lhs_position <= max_distance) {
+                return true;
+            }
+            lhs_index = GallopLowerBound(lhs, lhs_index, rhs_position - max_distance);
+        }
+        else {
+            if (lhs_position - rhs_position <= max_distance) {
+                return true;
+            }
+            rhs_index = GallopLowerBound(rhs, rhs_index, lhs_position - max_distance);
+        }
+    }
+    return false;
+}
+
+bool ContainsNearRepeat(const vector<uint32_t>& positions, uint32_t max_distance) {
+    for (size_t i = 1; i < positions.size(); ++i) {
+        if (positions[i] - positions[i - 1] <= max_distance) {
+            return true;
+        }
+    }
+    return false;
+}
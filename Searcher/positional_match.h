@@ -0,0 +1,13 @@
+#pragma once
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+// Both functions expect every position list to be sorted in ascending order.
+bool ContainsPhrase(std::span<const std::vector<uint32_t>* const> word_positions,
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+bool ContainsNearPair(const std::vector<uint32_t>& lhs, const std::vector<uint32_t>& rhs, uint32_t max_distance);
+
+// NEAR/k with the same word on both sides needs two distinct occurrences.
+bool ContainsNearRepeat(const std::vector<uint32_t>& positions, uint32_t max_distance);
@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <bit>
+
+#include "posting_list.h"
+
+using namespace std;
+
+namespace {
+
+class BitWriter {
+public:
+    explicit BitWriter(vector<uint8_t>& output)
+        : output_(output) {
+    }
+
+    void Write(uint32_t value, int width) {
+        buffer_ |= static_cast<uint64_t>(value) << buffered_bits_;
+        buffered_bits_ += width;
+        while (buffered_bits_ >= 8) {
+            output_.push_back(static_cast<uint8_t>(buffer_));
+            buffer_ >>= 8;
+            buffered_bits_ -= 8;
+        }
+    }
+
+    void Flush() {
+        if (buffered_bits_ > 0) {
+            output_.push_back(static_cast<uint8_t>(buffer_));
+        }
+        buffer_ = 0;
+        buffered_bits_ = 0;
+    }
+
+private:
+    vector<uint8_t>& output_;
+    uint64_t buffer_ = 0;
+    int buffered_bits_ = 0;
+};
+
+class BitReader {
+public:
+    explicit BitReader(const uint8_t* data)
+        : data_(data) {
+    }
+
+    uint32_t Read(int width) {
+        while (buffered_bits_ < width) {
+            buffer_ |= static_cast<uint64_t>(*data_++) << buffered_bits_;
+            buffered_bits_ += 8;
+        }
+        const uint32_t value = static_cast<uint32_t>(buffer_ & ((uint64_t{ 1 } << width) - 1));
+        buffer_ >>= width;
+        buffered_bits_ -= width;
+        return value;
+    }
+
+private:
+    const uint8_t* data_;
+    uint64_t buffer_ = 0;
+    int buffered_bits_ = 0;
+};
+
+bool IsLessDocumentId(const RawPosting& posting, int document_id) {
+    return posting.document_id < document_id;
+}
+
+}
+
+double RawPosting::GetTermFreq() const {
+    return static_cast<double>(term_count) / document_length;
+}
+
+void PostingList::Add(int document_id, uint32_t term_count, uint32_t document_length) {
+    if (blocks_.empty() || blocks_.back().last_document_id < document_id) {
+        const auto it = lower_bound(tail_.begin(), tail_.end(), document_id, IsLessDocumentId);
+        if (it != tail_.end() && it->document_id == document_id) {
+            it->term_count += term_count;
+        }
+        else {
+            tail_.insert(it, { document_id, term_count, document_length });
+            ++size_;
+        }
+
+        if (tail_.size() >= BLOCK_SIZE) {
+            SealTail();
+        }
+        else {
+            UpdateTailBlock();
+        }
+        return;
+    }
+
+    const size_t block = FindBlock(document_id);
+    vector<RawPosting> postings(blocks_[block].size);
+    DecodeBlock(block, postings.data());
+    const auto it = lower_bound(postings.begin(), postings.end(), document_id, IsLessDocumentId);
+    if (it != postings.end() && it->document_id == document_id) {
+        it->term_count += term_count;
+    }
+    else {
+        postings.insert(it, { document_id, term_count, document_length });
+        ++size_;
+    }
+    ReplaceBlock(block, postings);
+}
+
+bool PostingList::Remove(int document_id) {
+    if (blocks_.empty() || blocks_.back().last_document_id < document_id) {
+        const auto it = lower_bound(tail_.begin(), tail_.end(), document_id, IsLessDocumentId);
+        if (it == tail_.end() || it->document_id != document_id) {
+            return false;
+        }
+        tail_.erase(it);
+        --size_;
+        UpdateTailBlock();
+        return true;
+    }
+
+    const size_t block = FindBlock(document_id);
+    if (blocks_[block].first_document_id > document_id) {
+        return false;
+    }
+    vector<RawPosting> postings(blocks_[block].size);
+    DecodeBlock(block, postings.data());
+    const auto it = lower_bound(postings.begin(), postings.end(), document_id, IsLessDocumentId);
+    if (it == postings.end() || it->document_id != document_id) {
+        return false;
+    }
+    postings.erase(it);
+    --size_;
+    ReplaceBlock(block, postings);
+    return true;
+}
+
+bool PostingList::Contains(int document_id) const {
+    if (blocks_.empty() || blocks_.back().last_document_id < document_id) {
+        return binary_search(tail_.begin(), tail_.end(), RawPosting{ document_id },
+            [](const RawPosting& lhs, const RawPosting& rhs) {
+                return lhs.document_id < rhs.document_id;
+            });
+    }
+
+    const size_t block = FindBlock(document_id);
+    if (blocks_[block].first_document_id > document_id) {
+        return false;
+    }
+    array<RawPosting, MAX_BLOCK_SIZE> postings;
+    const auto end = postings.begin() + DecodeBlock(block, postings.data());
+    const auto it = lower_bound(postings.begin(), end, document_id, IsLessDocumentId);
+    return it != end && it->document_id == document_id;
+}
+
+size_t PostingList::size() const {
+    return size_;
+}
+
+bool PostingList::empty() const {
+    return size_ == 0;
+}
+
+size_t PostingList::GetBlockCount() const {
+    return blocks_.size() + (tail_.empty() ? 0 : 1);
+}
+
+const PostingBlock& PostingList::GetBlock(size_t block) const {
+    return block < blocks_.size() ? blocks_[block] : tail_block_;
+}
+
+size_t PostingList::DecodeBlock(size_t block, RawPosting* output) const {
+    if (block >= blocks_.size()) {
+        copy(tail_.begin(), tail_.end(), output);
+        return tail_.size();
+    }
+
+    const PostingBlock& posting_block = blocks_[block];
+    BitReader reader(data_.data() + posting_block.data_offset);
+    int64_t document_id = posting_block.first_document_id;
+    output[0].document_id = posting_block.first_document_id;
+    for (uint32_t i = 1; i < posting_block.size; ++i) {
+        document_id += static_cast<int64_t>(reader.Read(posting_block.gap_bits)) + 1;
+        output[i].document_id = static_cast<int>(document_id);
+    }
+    for (uint32_t i = 0; i < posting_block.size; ++i) {
+        output[i].term_count = reader.Read(posting_block.count_bits) + 1;
+    }
+    for (uint32_t i = 0; i < posting_block.size; ++i) {
+        output[i].document_length = reader.Read(posting_block.length_bits);
+    }
+    return posting_block.size;
+}
+
+size_t PostingList::FindBlock(int document_id) const {
+    return lower_bound(blocks_.begin(), blocks_.end(), document_id,
+        [](const PostingBlock& block, int id) {
+            return block.last_document_id < id;
+        }) - blocks_.begin();
+}
+
+void PostingList::UpdateTailBlock() {
+    tail_block_ = {};
+    if (tail_.empty()) {
+        return;
+    }
+    tail_block_.first_document_id = tail_.front().document_id;
+    tail_block_.last_document_id = tail_.back().document_id;
+    tail_block_.size = static_cast<uint32_t>(tail_.size());
+    tail_block_.min_document_length = tail_.front().document_length;
+    for (const RawPosting& posting : tail_) {
+        tail_block_.max_term_freq = max(tail_block_.max_term_freq, posting.GetTermFreq());
+        tail_block_.max_term_count = max(tail_block_.max_term_count, posting.term_count);
+        tail_block_.min_document_length = min(tail_block_.min_document_length, posting.document_length);
+    }
+}
+
+void PostingList::SealTail() {
+    blocks_.push_back(EncodeBlock(tail_.data(), tail_.size(), data_));
+    tail_.clear();
+    UpdateTailBlock();
+}
+
+void PostingList::ReplaceBlock(size_t block, const vector<RawPosting>& postings) {
+    const size_t begin = blocks_[block].data_offset;
+    const size_t end = block + 1 < blocks_.size() ? blocks_[block + 1].data_offset : data_.size();
+
+    vector<uint8_t> bytes;
+    vector<PostingBlock> new_blocks;
+    if (postings.size() > MAX_BLOCK_SIZE) {
+        const size_t half = postings.size() / 2;
+        new_blocks.push_back(EncodeBlock(postings.data(), half, bytes));
+        new_blocks.push_back(EncodeBlock(postings.data() + half, postings.size() - half, bytes));
+    }
+    else if (!postings.empty()) {
+        new_blocks.push_back(EncodeBlock(postings.data(), postings.size(), bytes));
+    }
+    for (PostingBlock& new_block : new_blocks) {
+        new_block.data_offset += static_cast<uint32_t>(begin);
+    }
+
+    data_.erase(data_.begin() + begin, data_.begin() + end);
+    data_.insert(data_.begin() + begin, bytes.begin(), bytes.end());
+    for (size_t next = block + 1; next < blocks_.size(); ++next) {
+        blocks_[next].data_offset = static_cast<uint32_t>(blocks_[next].data_offset - (end - begin) + bytes.size());
+    }
+    blocks_.erase(blocks_.begin() + block);
+    blocks_.insert(blocks_.begin() + block, new_blocks.begin(), new_blocks.end());
+}
+
+PostingBlock PostingList::EncodeBlock(const RawPosting* postings, size_t count, vector<uint8_t>& output) {
+    PostingBlock block;
+    block.first_document_id = postings[0].document_id;
+    block.last_document_id = postings[count - 1].document_id;
+    block.size = static_cast<uint32_t>(count);
+    block.data_offset = static_cast<uint32_t>(output.size());
+
+    uint32_t max_gap = 0;
+    uint32_t max_count = 0;
+    uint32_t max_length = 0;
+    block.min_document_length = postings[0].document_length;
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) {
+            max_gap = max(max_gap, static_cast<uint32_t>(postings[i].document_id - postings[i - 1].document_id - 1));
+        }
+        max_count = max(max_count, postings[i].term_count - 1);
+        max_length = max(max_length, postings[i].document_length);
+        block.max_term_freq = max(block.max_term_freq, postings[i].GetTermFreq());
+        block.min_document_length = min(block.min_document_length, postings[i].document_length);
+    }
+    block.max_term_count = max_count + 1;
+    block.gap_bits = static_cast<uint8_t>(bit_width(max_gap));
+    block.count_bits = static_cast<uint8_t>(bit_width(max_count));
+    block.length_bits = static_cast<uint8_t>(bit_width(max_length));
+
+    BitWriter writer(output);
+    for (size_t i = 1; i < count; ++i) {
+        writer.Write(static_cast<uint32_t>(postings[i].document_id - postings[i - 1].document_id - 1), block.gap_bits);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        writer.Write(postings[i].term_count - 1, block.count_bits);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        writer.Write(postings[i].document_length, block.length_bits);
+    }
+    writer.Flush();
+    return block;
+}
+
+PostingCursor::PostingCursor(const PostingList& postings)
+    : PostingCursor(postings, 0, postings.GetBlockCount()) {
+}
+
+PostingCursor::PostingCursor(const PostingList& postings, size_t first_block, size_t end_block)
+    : postings_(&postings)
+    , block_(first_block)
+    , end_block_(end_block) {
+    if (!IsEnd()) {
+        DecodeBlock();
+    }
+}
+
+bool PostingCursor::IsEnd() const {
+    return block_ >= end_block_;
+}
+
+int PostingCursor::GetDocumentId() const {
+    return buffer_[position_].document_id;
+}
+
+double PostingCursor::GetTermFreq() const {
+    return buffer_[position_].GetTermFreq();
+}
+
+const RawPosting& PostingCursor::GetPosting() const {
+    return buffer_[position_];
+}
+
+const PostingBlock& PostingCursor::GetCurrentBlock() const {
+    return postings_->GetBlock(block_);
+}
+
+void PostingCursor::Next() {
+    if (++position_ == block_size_) {
+        ++block_;
+        if (!IsEnd()) {
+            DecodeBlock();
+        }
+    }
+}
+
+void PostingCursor::SkipBlocks(int document_id) {
+    while (!IsEnd() && postings_->GetBlock(block_).last_document_id < document_id) {
+        ++block_;
+        is_decoded_ = false;
+    }
+}
+
+bool PostingCursor::Seek(int document_id) {
+    SkipBlocks(document_id);
+    if (IsEnd()) {
+        return false;
+    }
+    if (!is_decoded_) {
+        DecodeBlock();
+    }
+    position_ = lower_bound(buffer_.begin() + position_, buffer_.begin() + block_size_, document_id, IsLessDocumentId)
+        - buffer_.begin();
+    return buffer_[position_].document_id == document_id;
+}
+
+void PostingCursor::DecodeBlock() {
+    block_size_ = postings_->DecodeBlock(block_, buffer_.data());
+    position_ = 0;
+    is_decoded_ = true;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+struct RawPosting {
+    int document_id = 0;
+    uint32_t term_count = 0;
+    uint32_t document_length = 0;
+
+    double GetTermFreq() const;
+};
+
+struct PostingBlock {
+    int first_document_id = 0;
+    int last_document_id = 0;
+    double max_term_freq = 0.0;
+    uint32_t max_term_count = 0;
+    uint32_t min_document_length = 0;
+    uint32_t size = 0;
+    uint32_t data_offset = 0;
+    uint8_t gap_bits = 0;
+    uint8_t count_bits = 0;
+    uint8_t length_bits = 0;
+};
+
+// Postings are kept in blocks of up to MAX_BLOCK_SIZE entries. Sealed blocks
+// store document id gaps, term counts and document lengths as fixed-width
+// bit-packed columns; the last, still growing block stays uncompressed until
+// it reaches BLOCK_SIZE entries.
+class PostingList {
+public:
+    static const size_t BLOCK_SIZE = 64;
+    static const size_t MAX_BLOCK_SIZE = 2 * BLOCK_SIZE;
+
+    void Add(int document_id, uint32_t term_count, uint32_t document_length);
+    bool Remove(int document_id);
+    bool Contains(int document_id) const;
+
+    size_t size() const;
+    bool empty() const;
+
+    size_t GetBlockCount() const;
+    const PostingBlock& GetBlock(size_t block) const;
+    size_t DecodeBlock(size_t block, RawPosting* output) const;
+
+    template <typename Function>
+    void ForEach(Function function) const;
+
+private:
+    std::vector<PostingBlock> blocks_;
+    std::vector<uint8_t> data_;
+    std::vector<RawPosting> tail_;
+    PostingBlock tail_block_;
+    size_t size_ = 0;
+
+    size_t FindBlock(int document_id) const;
+    void UpdateTailBlock();
+    void SealTail();
+    void ReplaceBlock(size_t block, const std::vector<RawPosting>& postings);
+    static PostingBlock EncodeBlock(const RawPosting* postings, size_t count, std::vector<uint8_t>& output);
+};
+
+class PostingCursor {
+public:
+    explicit PostingCursor(const PostingList& postings);
+    PostingCursor(const PostingList& postings, size_t first_block, size_t end_block);
+
+    bool IsEnd() const;
+    int GetDocumentId() const;
+    double GetTermFreq() const;
+    const RawPosting& GetPosting() const;
+    const PostingBlock& GetCurrentBlock() const;
+
+    void Next();
+    void SkipBlocks(int document_id);
+    bool Seek(int document_id);
+
+private:
+    const PostingList* postings_;
+    size_t block_;
+    size_t end_block_;
+    size_t position_ = 0;
+    size_t block_size_ = 0;
+    bool is_decoded_ = false;
+    std::array<RawPosting, PostingList::MAX_BLOCK_SIZE> buffer_;
+
+    void DecodeBlock();
+};
+
+template <typename Function>
+void PostingList::ForEach(Function function) const {
+    std::array<RawPosting, MAX_BLOCK_SIZE> buffer;
+    for (size_t block = 0; block < GetBlockCount(); ++block) {
+        const size_t count = DecodeBlock(block, buffer.data());
+        for (size_t i = 0; i < count; ++i) {
+            function(buffer[i]);
+        }
+    }
+}
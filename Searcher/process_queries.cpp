@@ -0,0 +1,45 @@
+#include <algorithm>
+#include <execution>
+#include <numeric>
+#include <span>
+
+#include "process_queries.h"
+
+using namespace std;
+
+vector<vector<Document>> ProcessQueries(const SearchServer& search_server,
+    const vector<string>& queries) {
+
+    vector<vector<Document>> documents_lists(queries.size());
+    transform(execution::par, queries.begin(), queries.end(), documents_lists.begin(),
+        [&search_server](const string& query) {
+            vector<Document> documents(MAX_RESULT_DOCUMENT_COUNT);
+            documents.resize(search_server.FindTopDocuments(query, span<Document>(documents)));
+            return documents;
+        });
+    return documents_lists;
+}
+
+vector<Document> ProcessQueriesJoined(const SearchServer& search_server,
+    const vector<string>& queries) {
+
+    vector<Document> documents(queries.size() * MAX_RESULT_DOCUMENT_COUNT);
+    vector<size_t> query_indexes(queries.size());
+    iota(query_indexes.begin(), query_indexes.end(), 0);
+    vector<size_t> documents_counts(queries.size());
+
+    transform(execution::par, query_indexes.begin(), query_indexes.end(), documents_counts.begin(),
+        [&](size_t index) {
+            return search_server.FindTopDocuments(queries[index],
+                span<Document>(documents).subspan(index * MAX_RESULT_DOCUMENT_COUNT, MAX_RESULT_DOCUMENT_COUNT));
+        });
+
+    auto output = documents.begin();
+    for (size_t index = 0; index < queries.size(); ++index) {
+        const auto slot = documents.begin() + index * MAX_RESULT_DOCUMENT_COUNT;
+        output = move(slot, slot + documents_counts[index], output);
+    }
+    documents.erase(output, documents.end());
+
+    return documents;
+}
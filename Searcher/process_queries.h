@@ -0,0 +1,14 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "document.h"
+#include "search_server.h"
+
+// Both run the queries in parallel and bypass the query cache, so the workers
+// never contend on its lock.
+std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server,
+    const std::vector<std::string>& queries);
+
+std::vector<Document> ProcessQueriesJoined(const SearchServer& search_server,
+    const std::vector<std::string>& queries);
@@ -0,0 +1,95 @@
+#include "query_cache.h"
+
+using namespace std;
+
+QueryCache::QueryCache(size_t capacity)
+    : capacity_(capacity) {
+}
+
+QueryCache::QueryCache(const QueryCache& other)
+    : capacity_(other.GetCapacity()) {
+}
+
+QueryCache& QueryCache::operator=(const QueryCache& other) {
+    if (this != &other) {
+        const size_t capacity = other.GetCapacity();
+        lock_guard guard(mutex_);
+        capacity_ = capacity;
+        generation_ = 0;
+        entries_.clear();
+        positions_.clear();
+    }
+    return *this;
+}
+
+optional<vector<Document>> QueryCache::Find(string_view key, uint64_t generation) {
+    lock_guard guard(mutex_);
+    SetGeneration(generation);
+    const auto it = positions_.find(key);
+    if (it == positions_.end()) {
+        ++miss_count_;
+        return nullopt;
+    }
+    ++hit_count_;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->documents;
+}
+
+void QueryCache::Insert(string_view key, uint64_t generation, const vector<Document>& documents) {
+    lock_guard guard(mutex_);
+    SetGeneration(generation);
+    if (capacity_ == 0) {
+        return;
+    }
+
+    const auto it = positions_.find(key);
+    if (it != positions_.end()) {
+        it->second->documents = documents;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return;
+    }
+    entries_.push_front({ string(key), documents });
+    positions_.emplace(entries_.front().key, entries_.begin());
+    EvictExcessEntries();
+}
+
+void QueryCache::SetCapacity(size_t capacity) {
+    lock_guard guard(mutex_);
+    capacity_ = capacity;
+    EvictExcessEntries();
+}
+
+size_t QueryCache::GetCapacity() const {
+    lock_guard guard(mutex_);
+    return capacity_;
+}
+
+size_t QueryCache::size() const {
+    lock_guard guard(mutex_);
+    return entries_.size();
+}
+
+uint64_t QueryCache::GetHitCount() const {
+    lock_guard guard(mutex_);
+    return hit_count_;
+}
+
+uint64_t QueryCache::GetMissCount() const {
+    lock_guard guard(mutex_);
+    return miss_count_;
+}
+
+void QueryCache::SetGeneration(uint64_t generation) {
+    if (generation != generation_) {
+        generation_ = generation;
+        entries_.clear();
+        positions_.clear();
+    }
+}
+
+void QueryCache::EvictExcessEntries() {
+    while (entries_.size() > capacity_) {
+        positions_.erase(entries_.back().key);
+        entries_.pop_back();
+    }
+}
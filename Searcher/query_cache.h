@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "document.h"
+
+// Thread-safe LRU cache of search results. Every entry belongs to the index
+// generation it was computed for; a lookup or insert with a newer generation
+// drops all cached results. Copies start empty with the same capacity.
+class QueryCache {
+public:
+    static const size_t DEFAULT_CAPACITY = 4096;
+
+    explicit QueryCache(size_t capacity = DEFAULT_CAPACITY);
+    QueryCache(const QueryCache& other);
+    QueryCache& operator=(const QueryCache& other);
+
+    std::optional<std::vector<Document>> Find(std::string_view key, uint64_t generation);
+    void Insert(std::string_view key, uint64_t generation, const std::vector<Document>& documents);
+
+    void SetCapacity(size_t capacity);
+    size_t GetCapacity() const;
+    size_t size() const;
+    uint64_t GetHitCount() const;
+    uint64_t GetMissCount() const;
+
+private:
+    struct Entry {
+        std::string key;
+        std::vector<Document> documents;
+    };
+
+    mutable std::mutex mutex_;
+    size_t capacity_;
+    uint64_t generation_ = 0;
+    uint64_t hit_count_ = 0;
+    uint64_t miss_count_ = 0;
+    std::list<Entry> entries_;
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> positions_;
+
+    void SetGeneration(uint64_t generation);
+    void EvictExcessEntries();
+};
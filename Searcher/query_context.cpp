@@ -0,0 +1,128 @@
+#include <algorithm>
+
+#include "query_context.h"
+
+using namespace std;
+
+CountingResource::CountingResource(pmr::memory_resource* upstream)
+    : upstream_(upstream) {
+}
+
+uint64_t CountingResource::GetAllocationCount() const {
+    return allocation_count_;
+}
+
+uint64_t CountingResource::GetAllocatedBytes() const {
+    return allocated_bytes_;
+}
+
+void CountingResource::ResetCounters() {
+    allocation_count_ = 0;
+    allocated_bytes_ = 0;
+}
+
+void* CountingResource::do_allocate(size_t bytes, size_t alignment) {
+    ++allocation_count_;
+    allocated_bytes_ += bytes;
+    return upstream_->allocate(bytes, alignment);
+}
+
+void CountingResource::do_deallocate(void* pointer, size_t bytes, size_t alignment) {
+    upstream_->deallocate(pointer, bytes, alignment);
+}
+
+bool CountingResource::do_is_equal(const pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+QueryContext& QueryContext::GetForThread() {
+    static thread_local QueryContext context;
+    return context;
+}
+
+QueryContext::QueryContext()
+    : buffer_(make_unique<byte[]>(buffer_size_))
+    , heap_(pmr::new_delete_resource())
+    , arena_(in_place, buffer_.get(), buffer_size_, &heap_)
+    , resource_(&*arena_) {
+}
+
+pmr::memory_resource* QueryContext::GetResource() {
+    return &resource_;
+}
+
+QueryContext::Statistics QueryContext::GetStatistics() const {
+    return { query_count_, resource_.GetAllocationCount(), resource_.GetAllocatedBytes(),
+        heap_.GetAllocationCount() };
+}
+
+void QueryContext::ResetStatistics() {
+    query_count_ = 0;
+    resource_.ResetCounters();
+    heap_.ResetCounters();
+    query_heap_allocation_count_ = 0;
+    query_heap_bytes_ = 0;
+    query_bytes_ = 0;
+}
+
+size_t QueryContext::GetBufferSize() const {
+    return buffer_size_;
+}
+
+void QueryContext::Enter() {
+    if (depth_++ == 0) {
+        query_heap_allocation_count_ = heap_.GetAllocationCount();
+        query_heap_bytes_ = heap_.GetAllocatedBytes();
+        query_bytes_ = resource_.GetAllocatedBytes();
+    }
+}
+
+void QueryContext::Leave() {
+    if (--depth_ > 0) {
+        return;
+    }
+    ++query_count_;
+    window_peak_bytes_ = max(window_peak_bytes_, resource_.GetAllocatedBytes() - query_bytes_);
+
+    if (heap_.GetAllocationCount() != query_heap_allocation_count_) {
+        // The arena overflowed; give it a buffer large enough for everything
+        // this query took, within the limit.
+        const size_t required_size = buffer_size_ + static_cast<size_t>(heap_.GetAllocatedBytes() - query_heap_bytes_);
+        ResizeBuffer(min(size_t{ MAX_BUFFER_SIZE }, max(2 * buffer_size_, required_size)));
+        return;
+    }
+    if (++window_query_count_ == SHRINK_WINDOW) {
+        const bool is_oversized = window_peak_bytes_ < buffer_size_ / 4;
+        window_query_count_ = 0;
+        window_peak_bytes_ = 0;
+        if (is_oversized) {
+            ResizeBuffer(max(size_t{ INITIAL_BUFFER_SIZE }, buffer_size_ / 2));
+            return;
+        }
+    }
+    arena_->release();
+}
+
+void QueryContext::ResizeBuffer(size_t buffer_size) {
+    if (buffer_size == buffer_size_) {
+        arena_->release();
+        return;
+    }
+    arena_.reset();
+    buffer_size_ = buffer_size;
+    buffer_ = make_unique<byte[]>(buffer_size_);
+    arena_.emplace(buffer_.get(), buffer_size_, &heap_);
+}
+
+QueryScope::QueryScope()
+    : context_(QueryContext::GetForThread()) {
+    context_.Enter();
+}
+
+QueryScope::~QueryScope() {
+    context_.Leave();
+}
+
+pmr::memory_resource* QueryScope::GetResource() const {
+    return context_.GetResource();
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+// Memory resource that counts allocations before passing them upstream.
+class CountingResource : public std::pmr::memory_resource {
+public:
+    explicit CountingResource(std::pmr::memory_resource* upstream);
+
+    uint64_t GetAllocationCount() const;
+    uint64_t GetAllocatedBytes() const;
+    void ResetCounters();
+
+private:
+    std::pmr::memory_resource* upstream_;
+    uint64_t allocation_count_ = 0;
+    uint64_t allocated_bytes_ = 0;
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
+
+// Per-thread arena for the temporaries of a search. Everything allocated while
+// a QueryScope is open is dropped at once when the outermost scope on the
+// thread closes. A query that overflows the arena buffer makes it grow up to
+// MAX_BUFFER_SIZE, so later queries of that size are served from the buffer.
+// If no query of a SHRINK_WINDOW-long run used a quarter of a grown buffer, it
+// is halved. Only allocations made through the query resource are counted;
+// results returned to callers still come from the global heap.
+class QueryContext {
+public:
+    static const size_t INITIAL_BUFFER_SIZE = 16 * 1024;
+    static const size_t MAX_BUFFER_SIZE = 1024 * 1024;
+    static const uint64_t SHRINK_WINDOW = 256;
+
+    struct Statistics {
+        uint64_t query_count = 0;
+        uint64_t allocation_count = 0;
+        uint64_t allocated_bytes = 0;
+        uint64_t arena_overflow_count = 0;
+    };
+
+    static QueryContext& GetForThread();
+
+    std::pmr::memory_resource* GetResource();
+    Statistics GetStatistics() const;
+    void ResetStatistics();
+    size_t GetBufferSize() const;
+
+private:
+    friend class QueryScope;
+
+    size_t buffer_size_ = INITIAL_BUFFER_SIZE;
+    std::unique_ptr<std::byte[]> buffer_;
+    CountingResource heap_;
+    std::optional<std::pmr::monotonic_buffer_resource> arena_;
+    CountingResource resource_;
+    int depth_ = 0;
+    uint64_t query_count_ = 0;
+    uint64_t query_heap_allocation_count_ = 0;
+    uint64_t query_heap_bytes_ = 0;
+    uint64_t query_bytes_ = 0;
+    uint64_t window_query_count_ = 0;
+    uint64_t window_peak_bytes_ = 0;
+
+    QueryContext();
+
+    void Enter();
+    void Leave();
+    void ResizeBuffer(size_t buffer_size);
+};
+
+class QueryScope {
+public:
+    QueryScope();
+    ~QueryScope();
+
+    QueryScope(const QueryScope&) = delete;
+    QueryScope& operator=(const QueryScope&) = delete;
+
+    std::pmr::memory_resource* GetResource() const;
+
+private:
+    QueryContext& context_;
+};
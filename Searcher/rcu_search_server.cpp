@@ -0,0 +1,78 @@
+#include <thread>
+
+#include "rcu_search_server.h"
+
+using namespace std;
+
+RcuSearchServer::RcuSearchServer(string_view stop_words)
+    : views_{ SearchServer(stop_words), SearchServer(stop_words) } {
+}
+
+void RcuSearchServer::AddDocument(int doc_id, string_view document, DocumentStatus status, const vector<int>& ratings) {
+    Update([&](SearchServer& server) {
+        server.AddDocument(doc_id, document, status, ratings);
+    });
+}
+
+void RcuSearchServer::AddDocuments(span<const NewDocument> documents) {
+    Update([documents](SearchServer& server) {
+        server.AddDocuments(documents);
+    });
+}
+
+void RcuSearchServer::RemoveDocument(int document_id) {
+    Update([document_id](SearchServer& server) {
+        server.RemoveDocument(document_id);
+    });
+}
+
+vector<Document> RcuSearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status, size_t max_count) const {
+    return Read([&](const SearchServer& server) {
+        return server.FindTopDocuments(raw_query,
+            [status](int, DocumentStatus document_status, int) {
+                return document_status == status;
+            },
+            max_count);
+    });
+}
+
+uint64_t RcuSearchServer::GetEpoch() const {
+    return epoch_.load();
+}
+
+RcuSearchServer::ReaderGuard::ReaderGuard(const RcuSearchServer& server)
+    : server_(server)
+    , slot_(server.reader_slots_[GetReaderSlot()]) {
+    // A reader is counted in the view it saw published; if the writer switched
+    // views meanwhile, it retries so the writer never misses it.
+    while (true) {
+        view_ = server_.published_view_.load();
+        slot_.readers[view_].fetch_add(1);
+        if (server_.published_view_.load() == view_) {
+            break;
+        }
+        slot_.readers[view_].fetch_sub(1);
+    }
+}
+
+RcuSearchServer::ReaderGuard::~ReaderGuard() {
+    slot_.readers[view_].fetch_sub(1);
+}
+
+const SearchServer& RcuSearchServer::ReaderGuard::GetView() const {
+    return server_.views_[view_];
+}
+
+void RcuSearchServer::WaitForReaders(size_t view) const {
+    for (const ReaderSlot& slot : reader_slots_) {
+        while (slot.readers[view].load() != 0) {
+            this_thread::yield();
+        }
+    }
+}
+
+size_t RcuSearchServer::GetReaderSlot() {
+    static atomic<size_t> next_slot = 0;
+    thread_local const size_t slot = next_slot.fetch_add(1) % READER_SLOT_COUNT;
+    return slot;
+}
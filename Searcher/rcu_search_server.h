@@ -0,0 +1,96 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "search_server.h"
+
+// Publishes SearchServer views to readers without locks. Two replicas are kept:
+// a write is applied to the unpublished one, which is then published, and the
+// old view is reused only after every reader that entered it has left. Readers
+// announce themselves in per-thread counter slots, so they do not contend on a
+// shared cache line. Writers are serialised with each other. Searches bypass
+// the replicas' query caches, whose mutex would be shared by all readers.
+class RcuSearchServer {
+public:
+    static const size_t READER_SLOT_COUNT = 64;
+
+    explicit RcuSearchServer(std::string_view stop_words);
+
+    template <typename Function>
+    auto Read(Function function) const;
+
+    // The function is applied to each replica in turn, so it must change them
+    // identically: it has to be deterministic and must not throw on the second
+    // replica once it has succeeded on the first.
+    template <typename Function>
+    void Update(Function function);
+
+    void AddDocument(int doc_id,
+        std::string_view document,
+        DocumentStatus status,
+        const std::vector<int>& ratings);
+
+    void AddDocuments(std::span<const NewDocument> documents);
+
+    void RemoveDocument(int document_id);
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query,
+        DocumentStatus status = DocumentStatus::ACTUAL,
+        size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    uint64_t GetEpoch() const;
+
+private:
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint32_t> readers[2] = {};
+    };
+
+    class ReaderGuard {
+    public:
+        ReaderGuard(const RcuSearchServer& server);
+        ~ReaderGuard();
+
+        ReaderGuard(const ReaderGuard&) = delete;
+        ReaderGuard& operator=(const ReaderGuard&) = delete;
+
+        const SearchServer& GetView() const;
+
+    private:
+        const RcuSearchServer& server_;
+        ReaderSlot& slot_;
+        size_t view_;
+    };
+
+    std::array<SearchServer, 2> views_;
+    std::atomic<size_t> published_view_ = 0;
+    std::atomic<uint64_t> epoch_ = 0;
+    mutable std::array<ReaderSlot, READER_SLOT_COUNT> reader_slots_;
+    std::mutex write_mutex_;
+
+    void WaitForReaders(size_t view) const;
+
+    static size_t GetReaderSlot();
+};
+
+template <typename Function>
+auto RcuSearchServer::Read(Function function) const {
+    const ReaderGuard guard(*this);
+    return function(guard.GetView());
+}
+
+template <typename Function>
+void RcuSearchServer::Update(Function function) {
+    std::lock_guard guard(write_mutex_);
+    const size_t old_view = published_view_.load();
+    function(views_[1 - old_view]);
+    published_view_.store(1 - old_view);
+    epoch_.fetch_add(1);
+    WaitForReaders(old_view);
+    function(views_[old_view]);
+}
@@ -0,0 +1,50 @@
+#include <iostream>
+#include <unordered_set>
+#include <vector>
+
+#include "remove_duplicates.h"
+
+using namespace std;
+
+namespace {
+
+struct WordSetHasher {
+    // Words returned by GetWordFrequencies are views into the server's term
+    // dictionary, so equal words share the same address.
+    size_t operator()(const vector<string_view>& words) const {
+        size_t hash = words.size();
+        for (const string_view word : words) {
+            hash = hash * 37 + hasher_(word.data());
+        }
+        return hash;
+    }
+
+    std::hash<const char*> hasher_;
+};
+
+}
+
+void RemoveDuplicates(SearchServer& search_server) {
+    // Ids are visited in ascending order, so the first copy of each document is
+    // the one that is kept. Removals are applied after the scan, each costing
+    // O(log N) plus the document's own terms.
+    unordered_set<vector<string_view>, WordSetHasher> word_sets;
+    vector<int> duplicate_ids;
+    for (const int document_id : search_server) {
+        const auto& word_freqs = search_server.GetWordFrequencies(document_id);
+        vector<string_view> words;
+        words.reserve(word_freqs.size());
+        for (const auto& [word, _] : word_freqs) {
+            words.push_back(word);
+        }
+
+        if (!word_sets.insert(move(words)).second) {
+            duplicate_ids.push_back(document_id);
+        }
+    }
+
+    for (const int document_id : duplicate_ids) {
+        cout << "Found duplicate document id "s << document_id << endl;
+        search_server.RemoveDocument(document_id);
+    }
+}
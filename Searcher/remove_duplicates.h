@@ -0,0 +1,4 @@
+#pragma once
+#include "search_server.h"
+
+void RemoveDuplicates(SearchServer& search_server);
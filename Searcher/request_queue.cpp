@@ -1,14 +1,57 @@
+#include <stdexcept>
+
 #include "request_queue.h"
 
 using namespace std;
 
-RequestQueue::RequestQueue(const SearchServer& search_server) : server(search_server) {}
+RequestQueue::RequestQueue(const SearchServer& search_server, chrono::minutes window)
+    : server(search_server)
+    , window_minutes_(window.count() > 0 ? static_cast<uint32_t>(window.count()) : throw invalid_argument("Window must be positive"))
+    , buckets_(make_unique<atomic<uint64_t>[]>(window_minutes_)) {
+}
 
 vector<Document> RequestQueue::AddFindRequest(const string& raw_query, DocumentStatus status) {
-    return AddFindRequest(raw_query, [status](int document_id, DocumentStatus status_lambda, int rating) {
-        return status == status_lambda; });
+    vector<Document> result = server.FindTopDocuments(raw_query, status);
+    RecordRequest(result.empty());
+    return result;
+}
+
+void RequestQueue::RecordRequest(bool is_empty, Clock::time_point time) {
+    const uint32_t minute = GetMinute(time);
+    atomic<uint64_t>& bucket = buckets_[minute % window_minutes_];
+    uint64_t old_value = bucket.load(memory_order_relaxed);
+    uint64_t new_value;
+    do {
+        const uint32_t bucket_minute = static_cast<uint32_t>(old_value >> MINUTE_SHIFT);
+        if (bucket_minute == minute) {
+            if (!is_empty) {
+                return;
+            }
+            new_value = old_value + 1;
+        }
+        else if (static_cast<int32_t>(minute - bucket_minute) > 0) {
+            new_value = (static_cast<uint64_t>(minute) << MINUTE_SHIFT) | (is_empty ? 1u : 0u);
+        }
+        else {
+            // The bucket was already reused for a later minute.
+            return;
+        }
+    } while (!bucket.compare_exchange_weak(old_value, new_value, memory_order_relaxed));
 }
 
-int RequestQueue::GetNoResultRequests() const {
-    return empty_results_size_;
-}
\ No newline at end of file
+int RequestQueue::GetNoResultRequests(Clock::time_point now) const {
+    const uint32_t current_minute = GetMinute(now);
+    uint64_t result = 0;
+    for (uint32_t i = 0; i < window_minutes_; ++i) {
+        const uint64_t value = buckets_[i].load(memory_order_relaxed);
+        const uint32_t age = current_minute - static_cast<uint32_t>(value >> MINUTE_SHIFT);
+        if (age < window_minutes_) {
+            result += static_cast<uint32_t>(value);
+        }
+    }
+    return static_cast<int>(result);
+}
+
+uint32_t RequestQueue::GetMinute(Clock::time_point time) {
+    return static_cast<uint32_t>(chrono::duration_cast<chrono::minutes>(time.time_since_epoch()).count());
+}
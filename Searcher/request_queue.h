@@ -1,44 +1,45 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <vector>
-#include <deque>
 #include <string>
 
 #include "search_server.h"
 
+// Counts requests with empty results over a sliding time window. Requests are
+// recorded into per-minute buckets, each a single atomic word holding the minute
+// it belongs to and its empty-result count, so any number of threads can record
+// concurrently without locks. Buckets of minutes outside the window are ignored
+// and reused once the ring wraps around.
 class RequestQueue {
 public:
-    explicit RequestQueue(const SearchServer& search_server);
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::chrono::minutes DEFAULT_WINDOW{ 1440 };
+
+    explicit RequestQueue(const SearchServer& search_server, std::chrono::minutes window = DEFAULT_WINDOW);
 
     template <typename DocumentPredicate>
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate);
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentStatus status = DocumentStatus::ACTUAL);
-    int GetNoResultRequests() const;
+    void RecordRequest(bool is_empty, Clock::time_point time = Clock::now());
+    int GetNoResultRequests(Clock::time_point now = Clock::now()) const;
 
 private:
-    struct QueryResult {
-        bool is_empty_ = true;
-        std::vector<Document> result;
-    };
+    static const int MINUTE_SHIFT = 32;
 
-    std::deque<QueryResult> requests_;
-    const static int min_in_day_ = 1440;
     const SearchServer& server;
-    int empty_results_size_ = 0;
+    const uint32_t window_minutes_;
+    std::unique_ptr<std::atomic<uint64_t>[]> buckets_;
+
+    static uint32_t GetMinute(Clock::time_point time);
 };
 
 template<typename DocumentPredicate>
 inline std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) {
-    QueryResult result;
-    result.result = server.FindTopDocuments(raw_query, document_predicate);
-    result.is_empty_ = result.result.empty();
-
-    if (result.is_empty_) { empty_results_size_++; }
-
-    if (requests_.size() == min_in_day_) {
-        if (requests_.front().is_empty_) { empty_results_size_--; }
-        requests_.pop_front();
-    }
-    requests_.push_back(std::move(result));
-
-    return requests_.back().result;
-}
\ No newline at end of file
+    std::vector<Document> result = server.FindTopDocuments(raw_query, document_predicate);
+    RecordRequest(result.empty());
+    return result;
+}
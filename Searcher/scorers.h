@@ -0,0 +1,105 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+
+#include "posting_list.h"
+
+enum class ScoringModel {
+    TF_IDF,
+    BM25,
+};
+
+// Document count, total length and document frequencies of a collection that
+// is split into several indexes. Each index scores its documents with these
+// instead of its own statistics, so scores are comparable across indexes.
+struct CollectionStatistics {
+    size_t document_count = 0;
+    uint64_t total_document_length = 0;
+    std::map<std::string, size_t, std::less<>> document_freqs;
+
+    void Merge(const CollectionStatistics& other) {
+        document_count += other.document_count;
+        total_document_length += other.total_document_length;
+        for (const auto& [term, document_freq] : other.document_freqs) {
+            document_freqs[term] += document_freq;
+        }
+    }
+
+    size_t GetDocumentFreq(std::string_view term) const {
+        const auto it = document_freqs.find(term);
+        return it == document_freqs.end() ? 0 : it->second;
+    }
+};
+
+// Scorers are passed to the retrieval code as template arguments, so scoring a
+// posting is an inlined call. A term weight is computed once per query term;
+// block bounds must never be lower than the score of any posting in the block.
+class TfIdfScorer {
+public:
+    explicit TfIdfScorer(double log_document_count)
+        : log_document_count_(log_document_count) {
+    }
+
+    double ComputeTermWeight(double log_document_freq, size_t /*document_freq*/) const {
+        return log_document_count_ - log_document_freq;
+    }
+
+    double ComputeScore(double term_weight, uint32_t term_count, uint32_t document_length) const {
+        return static_cast<double>(term_count) / document_length * term_weight;
+    }
+
+    double ComputeBlockBound(double term_weight, const PostingBlock& block) const {
+        return block.max_term_freq * term_weight;
+    }
+
+private:
+    double log_document_count_;
+};
+
+class Bm25Scorer {
+public:
+    static constexpr double DEFAULT_K1 = 1.2;
+    static constexpr double DEFAULT_B = 0.75;
+
+    Bm25Scorer(size_t document_count, double average_document_length,
+        double k1 = DEFAULT_K1, double b = DEFAULT_B)
+        : document_count_(static_cast<double>(document_count))
+        , inverse_average_length_(average_document_length > 0.0 ? 1.0 / average_document_length : 0.0)
+        , k1_(k1)
+        , b_(b) {
+    }
+
+    double ComputeTermWeight(double /*log_document_freq*/, size_t document_freq) const {
+        const double freq = static_cast<double>(document_freq);
+        return std::log((document_count_ - freq + 0.5) / (freq + 0.5) + 1.0);
+    }
+
+    double ComputeScore(double term_weight, uint32_t term_count, uint32_t document_length) const {
+        const double count = static_cast<double>(term_count);
+        const double length_norm = 1.0 - b_ + b_ * document_length * inverse_average_length_;
+        return term_weight * count * (k1_ + 1.0) / (count + k1_ * length_norm);
+    }
+
+    double ComputeBlockBound(double term_weight, const PostingBlock& block) const {
+        return ComputeScore(term_weight, block.max_term_count, block.min_document_length);
+    }
+
+private:
+    double document_count_;
+    double inverse_average_length_;
+    double k1_;
+    double b_;
+};
+
+template <typename Scorer>
+double ComputeUpperBound(const Scorer& scorer, double term_weight, const PostingList& postings) {
+    double upper_bound = 0.0;
+    for (size_t block = 0; block < postings.GetBlockCount(); ++block) {
+        upper_bound = std::max(upper_bound, scorer.ComputeBlockBound(term_weight, postings.GetBlock(block)));
+    }
+    return upper_bound;
+}
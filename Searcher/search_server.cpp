@@ -1,20 +1,20 @@
 #include <numeric>
 #include <cmath>
+#include <charconv>
+#include <limits>
+#include <thread>
 
 #include "search_server.h"
 #include "read_input_functions.h"
+#include "index_snapshot.h"
+#include "positional_match.h"
 
 bool SearchServer::IsCharSpecSymbol(char c) {
     return c >= '\0' && c < ' ';
 }
 
-bool SearchServer::IsNotContainSpecSymbols(const std::string& text) {
-    for (const char& c : text) {
-        if (IsCharSpecSymbol(c)) {
-            return false;
-        }
-    }
-    return true;
+bool SearchServer::IsNotContainSpecSymbols(std::string_view text) {
+    return !ContainsSpecSymbols(text);
 }
 
 bool SearchServer::IsCharsAreDoubleMinus(const char* c) {
@@ -26,82 +26,352 @@ bool SearchServer::IsNotCharsAfterMinus(const char* c) {
 }
 
 SearchServer::SearchServer(const std::string& text) :
+    SearchServer(std::string_view(text)) {}
+
+SearchServer::SearchServer(std::string_view text) :
     SearchServer(SplitIntoWords(text)) {}
 
-void SearchServer::SetStopWords(const std::string& text) {
-    if (!IsNotContainSpecSymbols(text)) {
+SearchServer::SearchServer(const SearchServer& other)
+    : document_count_(other.document_count_)
+    , log_document_count_(other.log_document_count_)
+    , total_document_length_(other.total_document_length_)
+    , scoring_model_(other.scoring_model_)
+    , generation_(other.generation_)
+    , query_cache_(other.query_cache_)
+    , stop_words_(other.stop_words_)
+    , index_(other.index_)
+    , documents_(other.documents_)
+    , document_numbers_(other.document_numbers_)
+    , ids(other.ids)
+    , document_order_(other.document_order_) {
+    for (const auto& [document_id, word_freqs] : other.document_to_word_freqs_) {
+        std::map<std::string_view, double>& copied_word_freqs = document_to_word_freqs_[document_id];
+        for (const auto& [word, freq] : word_freqs) {
+            copied_word_freqs.emplace_hint(copied_word_freqs.end(), index_.GetTerm(index_.FindTerm(word)), freq);
+        }
+    }
+}
+
+SearchServer& SearchServer::operator=(const SearchServer& other) {
+    if (this != &other) {
+        *this = SearchServer(other);
+    }
+    return *this;
+}
+
+void SearchServer::SetStopWords(std::string_view text) {
+    const std::optional<std::vector<std::string_view>> words = SplitIntoCleanWords(text);
+    if (!words) {
         throw std::invalid_argument("Stop words query contains special symbols");
     }
 
-    for (const std::string& word : SplitIntoWords(text)) {
-        stop_words_.insert(word);
+    for (const std::string_view word : *words) {
+        stop_words_.emplace(word);
+    }
+    ++generation_;
+}
+
+void SearchServer::EnablePositionalIndex() {
+    if (!documents_.empty()) {
+        throw std::invalid_argument("Positional index must be enabled before documents are added");
     }
+    index_.EnablePositions();
+}
+
+void SearchServer::SetScoringModel(ScoringModel scoring_model) {
+    scoring_model_ = scoring_model;
+    ++generation_;
+}
+
+ScoringModel SearchServer::GetScoringModel() const {
+    return scoring_model_;
+}
+
+void SearchServer::SetQueryCacheCapacity(size_t capacity) {
+    query_cache_.SetCapacity(capacity);
+}
+
+const QueryCache& SearchServer::GetQueryCache() const {
+    return query_cache_;
 }
 
 void SearchServer::AddDocument(int doc_id,
-    const std::string& document,
+    std::string_view document,
     DocumentStatus status,
     const std::vector<int>& ratings) {
 
-    if (documents_.count(doc_id) ||
-        doc_id < 0 ||
-        !IsNotContainSpecSymbols(document)) {
+    CheckNewDocument(doc_id);
+    const std::optional<TokenizedDocument> tokenized_document = TokenizeDocument(document);
+    if (!tokenized_document) {
         throw std::invalid_argument("The dirty document is added");
-    };
+    }
+    const int document_number = static_cast<int>(documents_.size());
+    const std::vector<int> term_ids = RegisterDocument(doc_id, status, ratings, *tokenized_document);
+    for (size_t i = 0; i < term_ids.size(); ++i) {
+        IndexDocumentTerm(document_number, *tokenized_document, i, term_ids[i]);
+    }
+}
 
-    ++document_count_;
-    ids.push_back(doc_id);
-    const std::vector<std::string> words = SplitIntoWordsNoStop(document);
-    const double inv_word_count = 1.0 / words.size();
-    documents_[doc_id].rating = ComputeAverageRating(ratings);
-    documents_[doc_id].status = status;
+void SearchServer::AddDocuments(std::span<const NewDocument> documents) {
+    std::set<int> batch_ids;
+    for (const NewDocument& document : documents) {
+        CheckNewDocument(document.id);
+        if (!batch_ids.insert(document.id).second) {
+            throw std::invalid_argument("The dirty document is added");
+        }
+    }
 
-    for (const std::string& word : words) {
-        word_to_document_freqs_[word][doc_id] += inv_word_count;
+    std::vector<std::optional<TokenizedDocument>> tokenized_documents(documents.size());
+    std::transform(std::execution::par, documents.begin(), documents.end(), tokenized_documents.begin(),
+        [this](const NewDocument& document) { return TokenizeDocument(document.text); });
+    if (std::find(tokenized_documents.begin(), tokenized_documents.end(), std::nullopt) != tokenized_documents.end()) {
+        throw std::invalid_argument("The dirty document is added");
     }
+
+    const int first_number = static_cast<int>(documents_.size());
+    documents_.reserve(documents_.size() + documents.size());
+    std::vector<std::vector<int>> term_ids(documents.size());
+    for (size_t i = 0; i < documents.size(); ++i) {
+        term_ids[i] = RegisterDocument(documents[i].id, documents[i].status, documents[i].ratings, *tokenized_documents[i]);
+    }
+
+    // Postings are bucketed by term shard in document order, so each shard
+    // appends to its own posting lists without scanning the others' terms.
+    const size_t shard_count = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::vector<std::pair<size_t, size_t>>> shard_postings(shard_count);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        for (size_t term_index = 0; term_index < term_ids[i].size(); ++term_index) {
+            shard_postings[static_cast<size_t>(term_ids[i][term_index]) % shard_count].emplace_back(i, term_index);
+        }
+    }
+    std::for_each(std::execution::par, shard_postings.begin(), shard_postings.end(),
+        [&](const std::vector<std::pair<size_t, size_t>>& postings) {
+            for (const auto& [i, term_index] : postings) {
+                IndexDocumentTerm(first_number + static_cast<int>(i), *tokenized_documents[i], term_index, term_ids[i][term_index]);
+            }
+        });
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query,
+    const DocumentStatus status,
+    size_t max_count) const {
+
+    return FindTopDocuments(std::execution::seq, raw_query, status, max_count);
+}
+
+size_t SearchServer::FindTopDocuments(std::string_view raw_query, std::span<Document> output) const {
+    const QueryScope scope;
+    const Query query = ParseQuery(raw_query, true, scope.GetResource());
+    const auto document_predicate = [](int, DocumentStatus, int) {
+        return true;
+    };
+    return VisitScorer(query, [&](const auto& scorer) -> size_t {
+        if (query.plus_words.size() > 1) {
+            return FindTopDocumentsPruned(scorer, query, DocumentStatus::ACTUAL, document_predicate, output);
+        }
+        const std::vector<Document> matched_docs = FindAllDocuments(std::execution::seq, scorer, query,
+            DocumentStatus::ACTUAL, document_predicate);
+        return std::partial_sort_copy(matched_docs.begin(), matched_docs.end(), output.begin(), output.end(),
+            IsMoreRelevant) - output.begin();
+    });
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(const std::string& raw_query,
-    const DocumentStatus status) const {
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(std::string_view raw_query,
+    int document_id) const {
 
-    return FindTopDocuments(raw_query, [status](int document_id, DocumentStatus status_lambda, int rating) {
-        return status == status_lambda; }
-    );
+    return MatchDocument(std::execution::seq, raw_query, document_id);
 }
 
-std::tuple<std::vector<std::string>, DocumentStatus> SearchServer::MatchDocument(const std::string& raw_query,
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::execution::sequenced_policy&,
+    std::string_view raw_query,
     int document_id) const {
 
-    Query query = ParseQuery(raw_query);
-    std::tuple<std::vector<std::string>, DocumentStatus> matched_docs(std::tuple<std::vector<std::string>, DocumentStatus>{});
-    get<DocumentStatus>(matched_docs) = documents_.at(document_id).status;
+    const Query query = ParseQuery(raw_query);
+    std::tuple<std::vector<std::string_view>, DocumentStatus> matched_docs(std::tuple<std::vector<std::string_view>, DocumentStatus>{});
+    const int document_number = FindDocumentNumber(document_id);
+    get<DocumentStatus>(matched_docs) = documents_[document_number].status;
 
-    for (const std::string& word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) &&
-            word_to_document_freqs_.at(word).count(document_id)) {
+    for (const std::string_view word : query.minus_words) {
+        if (!FindIndexedWord(word, document_number).empty()) {
             return matched_docs;
         }
     }
+    if (!MatchesPositionalConstraints(query, document_number)) {
+        return matched_docs;
+    }
 
-    std::vector <std::string>& matched_words = get<0>(matched_docs);
-    std::set<std::string> plus_words(query.plus_words);
+    std::vector<std::string_view>& matched_words = get<0>(matched_docs);
 
-    for (const std::string& word : plus_words) {
-        if (word_to_document_freqs_.count(word)
-            && word_to_document_freqs_.at(word).count(document_id)) {
-            matched_words.push_back(word);
+    for (const std::string_view word : query.plus_words) {
+        const std::string_view indexed_word = FindIndexedWord(word, document_number);
+        if (!indexed_word.empty()) {
+            matched_words.push_back(indexed_word);
         }
     }
 
     return matched_docs;
 }
 
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::execution::parallel_policy& policy,
+    std::string_view raw_query,
+    int document_id) const {
+
+    const Query query = ParseQuery(raw_query, false);
+    std::tuple<std::vector<std::string_view>, DocumentStatus> matched_docs(std::tuple<std::vector<std::string_view>, DocumentStatus>{});
+    const int document_number = FindDocumentNumber(document_id);
+    get<DocumentStatus>(matched_docs) = documents_[document_number].status;
+
+    const bool has_minus_word = std::any_of(policy, query.minus_words.begin(), query.minus_words.end(),
+        [this, document_number](std::string_view word) {
+            return !FindIndexedWord(word, document_number).empty();
+        });
+    if (has_minus_word || !MatchesPositionalConstraints(query, document_number)) {
+        return matched_docs;
+    }
+
+    std::vector<std::string_view>& matched_words = get<0>(matched_docs);
+    matched_words.resize(query.plus_words.size());
+    std::transform(policy, query.plus_words.begin(), query.plus_words.end(), matched_words.begin(),
+        [this, document_number](std::string_view word) {
+            return FindIndexedWord(word, document_number);
+        });
+
+    matched_words.erase(std::remove(matched_words.begin(), matched_words.end(), std::string_view{}), matched_words.end());
+    RemoveDuplicateWords(matched_words);
+
+    return matched_docs;
+}
+
+void SearchServer::RemoveDocument(int document_id) {
+    RemoveDocument(std::execution::seq, document_id);
+}
+
+void SearchServer::SaveIndex(const std::string& path) const {
+    SnapshotWriter writer(path);
+    writer.WriteStrings(std::vector<std::string_view>(stop_words_.begin(), stop_words_.end()));
+    index_.Save(writer);
+
+    std::vector<int32_t> document_ids;
+    std::vector<int32_t> ratings;
+    std::vector<int32_t> statuses;
+    std::vector<uint32_t> lengths;
+    for (const DocumentData& data : documents_) {
+        document_ids.push_back(data.id);
+        ratings.push_back(data.rating);
+        statuses.push_back(static_cast<int32_t>(data.status));
+        lengths.push_back(data.length);
+    }
+    writer.WriteArray(document_ids);
+    writer.WriteArray(ratings);
+    writer.WriteArray(statuses);
+    writer.WriteArray(lengths);
+    writer.Finish();
+}
+
+void SearchServer::LoadIndex(const std::string& path) {
+    SnapshotReader reader(path);
+    SearchServer server(reader.ReadStrings());
+    server.index_.Load(reader);
+
+    const auto document_ids = reader.ReadArray<int32_t>();
+    const auto ratings = reader.ReadArray<int32_t>();
+    const auto statuses = reader.ReadArray<int32_t>();
+    const auto lengths = reader.ReadArray<uint32_t>();
+    if (ratings.size() != document_ids.size() || statuses.size() != document_ids.size()
+        || lengths.size() != document_ids.size()
+        || document_ids.size() > static_cast<size_t>(std::numeric_limits<int>::max())) {
+        throw std::invalid_argument("Index snapshot is corrupted");
+    }
+
+    for (size_t number = 0; number < document_ids.size(); ++number) {
+        if (statuses[number] < static_cast<int32_t>(DocumentStatus::ACTUAL)
+            || statuses[number] > static_cast<int32_t>(DocumentStatus::REMOVED)) {
+            throw std::invalid_argument("Index snapshot is corrupted");
+        }
+        server.documents_.push_back({ document_ids[number], ratings[number], static_cast<DocumentStatus>(statuses[number]), lengths[number] });
+        if (document_ids[number] == REMOVED_DOCUMENT_ID) {
+            continue;
+        }
+        server.total_document_length_ += lengths[number];
+        if (document_ids[number] < 0 || !server.document_numbers_.emplace(document_ids[number], static_cast<int>(number)).second) {
+            throw std::invalid_argument("Index snapshot is corrupted");
+        }
+        server.ids.insert(document_ids[number]);
+        server.document_order_.Add(static_cast<int>(number));
+        server.document_to_word_freqs_[document_ids[number]];
+    }
+    server.SetDocumentCount(static_cast<int>(server.ids.size()));
+
+    for (size_t term_id = 0; term_id < server.index_.GetTermCount(); ++term_id) {
+        const std::string_view word = server.index_.GetTerm(static_cast<int>(term_id));
+        server.index_.GetPostings(static_cast<int>(term_id)).ForEach([&server, word](const RawPosting& posting) {
+            if (posting.document_id < 0 || static_cast<size_t>(posting.document_id) >= server.documents_.size()) {
+                throw std::invalid_argument("Index snapshot is corrupted");
+            }
+            const auto it = server.document_to_word_freqs_.find(server.documents_[posting.document_id].id);
+            if (it == server.document_to_word_freqs_.end()) {
+                throw std::invalid_argument("Index snapshot is corrupted");
+            }
+            it->second[word] = posting.GetTermFreq();
+        });
+    }
+
+    server.scoring_model_ = scoring_model_;
+    server.generation_ = generation_ + 1;
+    server.query_cache_.SetCapacity(query_cache_.GetCapacity());
+    *this = std::move(server);
+}
+
+CollectionStatistics SearchServer::GetCollectionStatistics(const Query& query, const std::set<int>& excluded_ids) const {
+    CollectionStatistics statistics;
+    statistics.document_count = static_cast<size_t>(document_count_);
+    statistics.total_document_length = total_document_length_;
+    for (const std::string_view word : query.plus_words) {
+        const int term_id = index_.FindTerm(word);
+        statistics.document_freqs.emplace(word, term_id == InvertedIndex::NO_TERM ? 0 : index_.GetPostings(term_id).size());
+    }
+
+    for (const int document_id : excluded_ids) {
+        const auto document_it = document_to_word_freqs_.find(document_id);
+        if (document_it == document_to_word_freqs_.end()) {
+            continue;
+        }
+        --statistics.document_count;
+        statistics.total_document_length -= documents_[FindDocumentNumber(document_id)].length;
+        for (auto& [word, document_freq] : statistics.document_freqs) {
+            document_freq -= document_it->second.count(word);
+        }
+    }
+    return statistics;
+}
+
 int SearchServer::GetDocumentCount() {
     return document_count_;
 }
 
 int SearchServer::GetDocumentId(int index) const {
-    return ids.at(index);
+    if (index < 0 || static_cast<size_t>(index) >= document_order_.size()) {
+        throw std::out_of_range("Document index is out of range");
+    }
+    return documents_[document_order_.GetDocumentNumber(static_cast<size_t>(index))].id;
+}
+
+std::set<int>::const_iterator SearchServer::begin() const {
+    return ids.begin();
+}
+
+std::set<int>::const_iterator SearchServer::end() const {
+    return ids.end();
+}
+
+const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
+    static const std::map<std::string_view, double> empty_word_freqs;
+
+    const auto it = document_to_word_freqs_.find(document_id);
+    if (it == document_to_word_freqs_.end()) {
+        return empty_word_freqs;
+    }
+    return it->second;
 }
 
 int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
@@ -118,57 +388,322 @@ int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
     return static_rating;
 }
 
-bool SearchServer::IsStopWord(const std::string& word) const {
+bool SearchServer::IsStopWord(std::string_view word) const {
     return stop_words_.count(word) > 0;
 }
 
-std::vector<std::string> SearchServer::SplitIntoWordsNoStop(const std::string& text) const {
-    std::vector<std::string> words;
-    for (const std::string& word : SplitIntoWords(text)) {
-        if (!IsStopWord(word)) {
-            words.push_back(word);
-        }
+std::optional<std::vector<std::string_view>> SearchServer::SplitIntoWordsNoStop(std::string_view text) const {
+    std::optional<std::vector<std::string_view>> words = SplitIntoCleanWords(text);
+    if (words) {
+        std::erase_if(*words, [this](std::string_view word) { return IsStopWord(word); });
     }
     return words;
 }
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(std::string text) const {
+void SearchServer::CheckNewDocument(int doc_id) const {
+    if (document_numbers_.count(doc_id) ||
+        doc_id < 0) {
+        throw std::invalid_argument("The dirty document is added");
+    };
+}
+
+std::optional<SearchServer::TokenizedDocument> SearchServer::TokenizeDocument(std::string_view document) const {
+    const std::optional<std::vector<std::string_view>> clean_words = SplitIntoWordsNoStop(document);
+    if (!clean_words) {
+        return std::nullopt;
+    }
+    const std::vector<std::string_view>& words = *clean_words;
+    std::vector<std::pair<std::string_view, uint32_t>> word_positions;
+    word_positions.reserve(words.size());
+    for (size_t position = 0; position < words.size(); ++position) {
+        word_positions.push_back({ words[position], static_cast<uint32_t>(position) });
+    }
+    std::sort(word_positions.begin(), word_positions.end());
+
+    TokenizedDocument result;
+    result.length = static_cast<uint32_t>(words.size());
+    for (auto it = word_positions.begin(); it != word_positions.end();) {
+        const std::string_view word = it->first;
+        std::vector<uint32_t> positions;
+        for (; it != word_positions.end() && it->first == word; ++it) {
+            positions.push_back(it->second);
+        }
+        result.term_counts.push_back({ word, static_cast<uint32_t>(positions.size()) });
+        if (index_.HasPositions()) {
+            result.positions.push_back(std::move(positions));
+        }
+    }
+    return result;
+}
+
+std::vector<int> SearchServer::RegisterDocument(int doc_id, DocumentStatus status, const std::vector<int>& ratings,
+    const TokenizedDocument& document) {
+    SetDocumentCount(document_count_ + 1);
+    ids.insert(doc_id);
+    const int document_number = static_cast<int>(documents_.size());
+    documents_.push_back({ doc_id, ComputeAverageRating(ratings), status, document.length });
+    total_document_length_ += document.length;
+    ++generation_;
+    document_numbers_[doc_id] = document_number;
+    document_order_.Add(document_number);
+
+    std::map<std::string_view, double>& word_freqs = document_to_word_freqs_[doc_id];
+    std::vector<int> term_ids;
+    term_ids.reserve(document.term_counts.size());
+    for (const auto& [word, count] : document.term_counts) {
+        const int term_id = index_.AddTerm(word);
+        term_ids.push_back(term_id);
+        word_freqs[index_.GetTerm(term_id)] = static_cast<double>(count) / document.length;
+    }
+    return term_ids;
+}
+
+void SearchServer::IndexDocumentTerm(int document_number, const TokenizedDocument& document, size_t term_index, int term_id) {
+    index_.AddPosting(term_id, document_number, document.term_counts[term_index].second, document.length);
+    if (index_.HasPositions()) {
+        index_.AddPositions(term_id, document_number, document.positions[term_index]);
+    }
+}
+
+SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) const {
     bool is_minus = false;
     if (text[0] == '-') {
         is_minus = true;
-        text = text.substr(1);
+        text.remove_prefix(1);
     }
     return { text, is_minus, IsStopWord(text) };
 }
 
-SearchServer::Query SearchServer::ParseQuery(const std::string& text) const {
-    if (!IsClearRawQuery(text)) { throw std::invalid_argument("Query is dirty"); }
+SearchServer::Query SearchServer::ParseQuery(std::string_view text, bool remove_duplicates,
+    std::pmr::memory_resource* resource) const {
+    const std::optional<std::pmr::vector<std::string_view>> clean_tokens = SplitIntoCleanWords(text, resource);
+    if (!clean_tokens || !std::all_of(clean_tokens->begin(), clean_tokens->end(), IsClearQueryWord)) {
+        throw std::invalid_argument("Query is dirty");
+    }
 
-    Query query;
-    for (const std::string& word : SplitIntoWords(text)) {
-        const QueryWord query_word = ParseQueryWord(word);
+    Query query(resource);
+    const std::pmr::vector<std::string_view>& tokens = *clean_tokens;
+    // NEAR/k binds the plus word of the token right before it; a minus word,
+    // a stop word or an empty phrase leaves nothing to bind.
+    std::optional<std::string_view> previous_plus_word;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        if (tokens[i].front() == '"') {
+            const size_t plus_word_count = query.plus_words.size();
+            i = ParsePhrase(tokens, i, query);
+            previous_plus_word = query.plus_words.size() > plus_word_count
+                ? std::optional(query.plus_words.back()) : std::nullopt;
+            continue;
+        }
+
+        const std::optional<uint32_t> max_distance = ParseNearOperator(tokens[i]);
+        if (max_distance) {
+            if (!previous_plus_word || i + 1 == tokens.size()) {
+                throw std::invalid_argument("Query is dirty");
+            }
+            const QueryWord next_word = ParseQueryWord(tokens[++i]);
+            if (next_word.is_minus || next_word.is_stop) {
+                throw std::invalid_argument("Query is dirty");
+            }
+            query.proximities.push_back({ *previous_plus_word, next_word.data, *max_distance });
+            query.plus_words.push_back(next_word.data);
+            previous_plus_word = next_word.data;
+            continue;
+        }
+
+        const QueryWord query_word = ParseQueryWord(tokens[i]);
+        previous_plus_word.reset();
         if (!query_word.is_stop) {
             if (query_word.is_minus) {
-                query.minus_words.insert(query_word.data);
+                query.minus_words.push_back(query_word.data);
             }
             else {
-                query.plus_words.insert(query_word.data);
+                query.plus_words.push_back(query_word.data);
+                previous_plus_word = query_word.data;
             }
         }
     }
+
+    if ((!query.phrases.empty() || !query.proximities.empty()) && !index_.HasPositions()) {
+        throw std::invalid_argument("Positional index is disabled");
+    }
+
+    if (remove_duplicates) {
+        RemoveDuplicateWords(query.plus_words);
+        RemoveDuplicateWords(query.minus_words);
+    }
     return query;
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(const std::string& word) const {
-    return log(document_count_ * 1.0 / word_to_document_freqs_.at(word).size());
+size_t SearchServer::ParsePhrase(const std::pmr::vector<std::string_view>& tokens, size_t first_token, Query& query) const {
+    std::pmr::vector<std::string_view> phrase(query.GetResource());
+    bool is_closed = false;
+    size_t token = first_token;
+    for (; token < tokens.size() && !is_closed; ++token) {
+        std::string_view word = tokens[token];
+        if (token == first_token) {
+            word.remove_prefix(1);
+        }
+        if (!word.empty() && word.back() == '"') {
+            word.remove_suffix(1);
+            is_closed = true;
+        }
+        if (!word.empty() && !IsStopWord(word)) {
+            phrase.push_back(word);
+        }
+    }
+    if (!is_closed) {
+        throw std::invalid_argument("Query is dirty");
+    }
+
+    query.plus_words.insert(query.plus_words.end(), phrase.begin(), phrase.end());
+    if (phrase.size() > 1) {
+        query.phrases.push_back(std::move(phrase));
+    }
+    return token - 1;
 }
 
-bool SearchServer::IsClearRawQuery(const std::string& raw_query) const {
-    for (const char& c : raw_query) {
-        bool is_dirty_query = IsCharSpecSymbol(c) || IsCharsAreDoubleMinus(&c) || IsNotCharsAfterMinus(&c);
-        if (is_dirty_query) {
+std::optional<uint32_t> SearchServer::ParseNearOperator(std::string_view word) {
+    const std::string_view near_prefix = "NEAR/";
+    if (word.size() <= near_prefix.size() || word.substr(0, near_prefix.size()) != near_prefix) {
+        return std::nullopt;
+    }
+    uint32_t max_distance = 0;
+    const char* last = word.data() + word.size();
+    const auto [end, error] = std::from_chars(word.data() + near_prefix.size(), last, max_distance);
+    if (error != std::errc() || end != last) {
+        return std::nullopt;
+    }
+    return max_distance;
+}
+
+DocumentIdSet SearchServer::BuildExcludedDocuments(const Query& query) const {
+    DocumentIdSet excluded_documents(query.GetResource());
+    for (const std::string_view word : query.minus_words) {
+        const int term_id = index_.FindTerm(word);
+        if (term_id == InvertedIndex::NO_TERM) {
+            continue;
+        }
+        index_.GetPostings(term_id).ForEach([&excluded_documents](const RawPosting& posting) {
+            excluded_documents.Insert(posting.document_id);
+        });
+    }
+    return excluded_documents;
+}
+
+bool SearchServer::IsDocumentNumberRangeDense() const {
+    return documents_.size() < dense_id_range_factor_ * document_numbers_.size();
+}
+
+int SearchServer::FindDocumentNumber(int document_id) const {
+    return document_numbers_.at(document_id);
+}
+
+DenseAccumulator& SearchServer::GetDenseAccumulator() {
+    static thread_local DenseAccumulator accumulator;
+    return accumulator;
+}
+
+bool SearchServer::MatchesPositionalConstraints(const Query& query, int document_number) const {
+    const auto find_positions = [this, document_number](std::string_view word) -> const std::vector<uint32_t>* {
+        const int term_id = index_.FindTerm(word);
+        return term_id == InvertedIndex::NO_TERM ? nullptr : index_.FindPositions(term_id, document_number);
+    };
+
+    for (const std::pmr::vector<std::string_view>& phrase : query.phrases) {
+        std::pmr::vector<const std::vector<uint32_t>*> word_positions(query.GetResource());
+        for (const std::string_view word : phrase) {
+            const std::vector<uint32_t>* positions = find_positions(word);
+            if (positions == nullptr) {
+                return false;
+            }
+            word_positions.push_back(positions);
+        }
+        if (!ContainsPhrase(word_positions, query.GetResource())) {
+            return false;
+        }
+    }
+
+    for (const Proximity& proximity : query.proximities) {
+        const std::vector<uint32_t>* first_positions = find_positions(proximity.first_word);
+        const std::vector<uint32_t>* second_positions = find_positions(proximity.second_word);
+        if (first_positions == nullptr || second_positions == nullptr) {
+            return false;
+        }
+        const bool is_near = first_positions == second_positions
+            ? ContainsNearRepeat(*first_positions, proximity.max_distance)
+            : ContainsNearPair(*first_positions, *second_positions, proximity.max_distance);
+        if (!is_near) {
             return false;
         }
     }
     return true;
+}
+
+size_t SearchServer::CountPostings(const Query& query) const {
+    size_t count = 0;
+    for (const std::string_view word : query.plus_words) {
+        const int term_id = index_.FindTerm(word);
+        if (term_id != InvertedIndex::NO_TERM) {
+            count += index_.GetPostings(term_id).size();
+        }
+    }
+    return count;
+}
+
+bool SearchServer::IsMoreRelevant(const Document& lhs, const Document& rhs) {
+    if (std::abs(lhs.relevance - rhs.relevance) < EPSILON) {
+        return lhs.rating > rhs.rating;
+    }
+    return lhs.relevance > rhs.relevance;
+}
+
+std::pmr::string SearchServer::BuildQueryCacheKey(const Query& query, bool is_sequenced, DocumentStatus status, size_t max_count) const {
+    const char separator = '\x01';
+    std::pmr::string key(query.GetResource());
+    key += std::to_string(is_sequenced);
+    key += separator;
+    key += std::to_string(static_cast<int>(status));
+    key += separator;
+    key += std::to_string(max_count);
+    const auto append_words = [&key, separator](char tag, std::span<const std::string_view> words) {
+        key += separator;
+        key += tag;
+        for (const std::string_view word : words) {
+            key += separator;
+            key += word;
+        }
+    };
+
+    append_words('+', query.plus_words);
+    append_words('-', query.minus_words);
+    for (const std::pmr::vector<std::string_view>& phrase : query.phrases) {
+        append_words('"', phrase);
+    }
+    for (const Proximity& proximity : query.proximities) {
+        const std::string_view pair[] = { proximity.first_word, proximity.second_word };
+        append_words('~', pair);
+        key += std::to_string(proximity.max_distance);
+    }
+    return key;
+}
+
+std::string_view SearchServer::FindIndexedWord(std::string_view word, int document_number) const {
+    const int term_id = index_.FindTerm(word);
+    if (term_id == InvertedIndex::NO_TERM || !index_.ContainsDocument(term_id, document_number)) {
+        return {};
+    }
+    return index_.GetTerm(term_id);
+}
+
+void SearchServer::SetDocumentCount(int document_count) {
+    document_count_ = document_count;
+    log_document_count_ = log(document_count * 1.0);
+}
+
+double SearchServer::GetAverageDocumentLength() const {
+    return document_count_ > 0 ? static_cast<double>(total_document_length_) / document_count_ : 0.0;
+}
+
+bool SearchServer::IsClearQueryWord(std::string_view word) {
+    return word.back() != '-' && word.find("--") == std::string_view::npos;
 }
\ No newline at end of file
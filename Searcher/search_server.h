@@ -1,89 +1,282 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include <set>
 #include <map>
 #include <tuple>
+#include <optional>
+#include <memory_resource>
+#include <span>
 #include <stdexcept>
 #include <algorithm>
+#include <execution>
 
 #include "document.h"
 #include "string_processing.h"
+#include "inverted_index.h"
+#include "concurrent_map.h"
+#include "document_id_set.h"
+#include "dense_accumulator.h"
+#include "document_order.h"
+#include "max_score_retriever.h"
+#include "scorers.h"
+#include "query_cache.h"
+#include "query_context.h"
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 const double EPSILON = 1e-6;
 
 class SearchServer {
 public:
+    struct Proximity {
+        std::string_view first_word;
+        std::string_view second_word;
+        uint32_t max_distance;
+    };
+
+    // Words of a query and everything derived from it are allocated from the
+    // resource the query was parsed with.
+    struct Query {
+        explicit Query(std::pmr::memory_resource* resource)
+            : plus_words(resource)
+            , minus_words(resource)
+            , phrases(resource)
+            , proximities(resource) {
+        }
+
+        std::pmr::memory_resource* GetResource() const {
+            return plus_words.get_allocator().resource();
+        }
+
+        std::pmr::vector<std::string_view> plus_words;
+        std::pmr::vector<std::string_view> minus_words;
+        std::pmr::vector<std::pmr::vector<std::string_view>> phrases;
+        std::pmr::vector<Proximity> proximities;
+        const CollectionStatistics* statistics = nullptr;
+    };
+
     template<class container>
     SearchServer(const container& cont);
 
     SearchServer(const std::string& text);
+    SearchServer(std::string_view text);
+
+    // Word views of a copy point into its own term dictionary.
+    SearchServer(const SearchServer& other);
+    SearchServer& operator=(const SearchServer& other);
+    SearchServer(SearchServer&& other) = default;
+    SearchServer& operator=(SearchServer&& other) = default;
 
-    void SetStopWords(const std::string& text);
+    void SetStopWords(std::string_view text);
+    void EnablePositionalIndex();
+    void SetScoringModel(ScoringModel scoring_model);
+    ScoringModel GetScoringModel() const;
+    void SetQueryCacheCapacity(size_t capacity);
+    const QueryCache& GetQueryCache() const;
 
     void AddDocument(int doc_id,
-        const std::string& document,
+        std::string_view document,
         DocumentStatus status,
         const std::vector<int>& ratings);
 
+    // Tokenises the batch in parallel and then fills posting lists of disjoint
+    // term shards concurrently. Either all documents are added or none.
+    void AddDocuments(std::span<const NewDocument> documents);
+
     template <typename DocumentPredicate>
-    std::vector<Document> FindTopDocuments(const std::string& raw_query,
-        DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query,
+        DocumentPredicate document_predicate,
+        size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+     std::vector<Document> FindTopDocuments(std::string_view raw_query,
+         const DocumentStatus status = DocumentStatus::ACTUAL,
+         size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
 
-     std::vector<Document> FindTopDocuments(const std::string& raw_query,
-         const DocumentStatus status = DocumentStatus::ACTUAL) const;
+    // Writes up to output.size() top actual documents straight into output and
+    // returns how many were written. These results bypass the query cache.
+    size_t FindTopDocuments(std::string_view raw_query, std::span<Document> output) const;
 
-    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(const std::string& raw_query,
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy,
+        std::string_view raw_query,
+        DocumentPredicate document_predicate,
+        size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy,
+        std::string_view raw_query,
+        const DocumentStatus status = DocumentStatus::ACTUAL,
+        size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    // A parsed query can be searched on any server with the same stop words.
+    // Its words are views into text.
+    Query ParseQuery(std::string_view text, bool remove_duplicates = true,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+
+    // If query.statistics is set, terms are weighted with the statistics of a
+    // whole collection this server is a part of. Such results are never cached.
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const Query& query,
+        DocumentPredicate document_predicate,
+        size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    // Statistics of the query terms, leaving out the excluded documents.
+    CollectionStatistics GetCollectionStatistics(const Query& query, const std::set<int>& excluded_ids = {}) const;
+
+    void RemoveDocument(int document_id);
+
+    template <typename ExecutionPolicy>
+    void RemoveDocument(const ExecutionPolicy& policy, int document_id);
+
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query,
+        int document_id) const;
+
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::sequenced_policy& policy,
+        std::string_view raw_query,
+        int document_id) const;
+
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::parallel_policy& policy,
+        std::string_view raw_query,
         int document_id) const;
 
+    void SaveIndex(const std::string& path) const;
+    void LoadIndex(const std::string& path);
+
     int GetDocumentCount();
     int GetDocumentId(int index) const;
+    std::set<int>::const_iterator begin() const;
+    std::set<int>::const_iterator end() const;
+    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
     
     static bool IsCharSpecSymbol(char c);
-    static bool IsNotContainSpecSymbols(const std::string& text);
+    static bool IsNotContainSpecSymbols(std::string_view text);
     static bool IsCharsAreDoubleMinus(const char* c);
     static bool IsNotCharsAfterMinus(const char* c);
 
 private:
+    static const int REMOVED_DOCUMENT_ID = -1;
+
     struct DocumentData {
+        int id;
         int rating;
         DocumentStatus status;
+        uint32_t length;
     };
     
     int document_count_ = 0;
-    std::set<std::string> stop_words_;
-    std::map<std::string, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, DocumentData> documents_;
-    std::vector<int> ids;
+    double log_document_count_ = 0.0;
+    uint64_t total_document_length_ = 0;
+    ScoringModel scoring_model_ = ScoringModel::TF_IDF;
+    uint64_t generation_ = 0;
+    mutable QueryCache query_cache_;
+    std::set<std::string, std::less<>> stop_words_;
+    InvertedIndex index_;
+    std::vector<DocumentData> documents_;
+    std::map<int, int> document_numbers_;
+    std::map<int, std::map<std::string_view, double>> document_to_word_freqs_;
+    std::set<int> ids;
+    DocumentOrder document_order_;
+
+    struct TokenizedDocument {
+        uint32_t length = 0;
+        std::vector<std::pair<std::string_view, uint32_t>> term_counts;
+        std::vector<std::vector<uint32_t>> positions;
+    };
 
     struct QueryWord {
-        std::string data;
+        std::string_view data;
         bool is_minus;
         bool is_stop;
     };
 
-    struct Query {
-        std::set<std::string> plus_words;
-        std::set<std::string> minus_words;
+    struct PostingRange {
+        const PostingList* postings;
+        size_t first_block;
+        size_t end_block;
+        double term_weight;
     };
 
-    template <typename predicat>
-    std::vector<Document> FindAllDocuments(const Query& query, predicat comp) const;
+    const static size_t relevance_bucket_count_ = 64;
+    const static size_t posting_range_size_ = 4096;
+    const static size_t dense_id_range_factor_ = 4;
+
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy,
+        const Query& query,
+        std::optional<DocumentStatus> status,
+        DocumentPredicate document_predicate,
+        size_t max_count) const;
+
+    template <typename Scorer, typename DocumentPredicate>
+    size_t FindTopDocumentsPruned(const Scorer& scorer, const Query& query, std::optional<DocumentStatus> status,
+        DocumentPredicate document_predicate, std::span<Document> output) const;
+
+    size_t CountPostings(const Query& query) const;
+
+    template <typename Scorer, typename predicat>
+    std::vector<Document> FindAllDocuments(const std::execution::sequenced_policy& policy, const Scorer& scorer,
+        const Query& query, std::optional<DocumentStatus> status, predicat comp) const;
+
+    template <typename Scorer, typename predicat>
+    std::vector<Document> FindAllDocuments(const std::execution::parallel_policy& policy, const Scorer& scorer,
+        const Query& query, std::optional<DocumentStatus> status, predicat comp) const;
+
+    template <typename Function>
+    auto VisitScorer(const Query& query, Function function) const;
+
+    template <typename Scorer>
+    double ComputeTermWeight(const Scorer& scorer, const Query& query, int term_id) const;
+
+    template <typename Scorer>
+    std::vector<PostingRange> SplitPlusWordsPostings(const Scorer& scorer, const Query& query) const;
+    DocumentIdSet BuildExcludedDocuments(const Query& query) const;
+    bool IsDocumentNumberRangeDense() const;
+    bool HasStatus(int document_number, std::optional<DocumentStatus> status) const;
+    int FindDocumentNumber(int document_id) const;
+    static DenseAccumulator& GetDenseAccumulator();
+
+    template <typename ExecutionPolicy>
+    static void SelectTopDocuments(const ExecutionPolicy& policy,
+        std::vector<Document>& documents, size_t max_count);
+
+    static bool IsMoreRelevant(const Document& lhs, const Document& rhs);
 
     static int ComputeAverageRating(const std::vector<int>& ratings);
 
-    bool IsStopWord(const std::string& word) const;
+    bool IsStopWord(std::string_view word) const;
+
+    std::optional<std::vector<std::string_view>> SplitIntoWordsNoStop(std::string_view text) const;
+
+    void CheckNewDocument(int doc_id) const;
+
+    std::optional<TokenizedDocument> TokenizeDocument(std::string_view document) const;
+
+    std::vector<int> RegisterDocument(int doc_id, DocumentStatus status, const std::vector<int>& ratings,
+        const TokenizedDocument& document);
+
+    void IndexDocumentTerm(int document_number, const TokenizedDocument& document, size_t term_index, int term_id);
+
+    QueryWord ParseQueryWord(std::string_view text) const;
+
+    size_t ParsePhrase(const std::pmr::vector<std::string_view>& tokens, size_t first_token, Query& query) const;
+
+    static std::optional<uint32_t> ParseNearOperator(std::string_view word);
 
-    std::vector<std::string> SplitIntoWordsNoStop(const std::string& text) const;
+    template <typename Words>
+    static void RemoveDuplicateWords(Words& words);
 
-    QueryWord ParseQueryWord(std::string text) const;
+    bool MatchesPositionalConstraints(const Query& query, int document_number) const;
 
-    Query ParseQuery(const std::string& text) const;
+    std::pmr::string BuildQueryCacheKey(const Query& query, bool is_sequenced, DocumentStatus status, size_t max_count) const;
 
-    double ComputeWordInverseDocumentFreq(const std::string& word) const;
+    std::string_view FindIndexedWord(std::string_view word, int document_number) const;
 
-    bool IsClearRawQuery(const std::string& raw_query) const;
+    void SetDocumentCount(int document_count);
+
+    double GetAverageDocumentLength() const;
+
+    static bool IsClearQueryWord(std::string_view word);
 };
 
 template<typename container>
@@ -92,58 +285,298 @@ SearchServer::SearchServer(const container& cont) {
         if (!IsNotContainSpecSymbols(word)) {
             throw std::invalid_argument("Stop words query contains special symbols");
         }
-        stop_words_.insert(word);
+        stop_words_.emplace(word);
     }
 }
 
+template <typename ExecutionPolicy>
+void SearchServer::RemoveDocument(const ExecutionPolicy& policy, int document_id) {
+    const auto document_it = document_to_word_freqs_.find(document_id);
+    if (document_it == document_to_word_freqs_.end()) {
+        return;
+    }
+    const int document_number = FindDocumentNumber(document_id);
+
+    const std::map<std::string_view, double>& word_freqs = document_it->second;
+    std::vector<int> term_ids(word_freqs.size());
+    std::transform(policy, word_freqs.begin(), word_freqs.end(), term_ids.begin(),
+        [this](const auto& word_freq) {
+            return index_.FindTerm(word_freq.first);
+        });
+    std::for_each(policy, term_ids.begin(), term_ids.end(),
+        [this, document_number](int term_id) {
+            index_.RemovePosting(term_id, document_number);
+        });
+
+    document_to_word_freqs_.erase(document_it);
+    document_numbers_.erase(document_id);
+    documents_[document_number].id = REMOVED_DOCUMENT_ID;
+    total_document_length_ -= documents_[document_number].length;
+    ++generation_;
+    ids.erase(document_id);
+    document_order_.Remove(document_number);
+    SetDocumentCount(document_count_ - 1);
+}
+
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(const std::string& raw_query,
-    DocumentPredicate document_predicate) const {
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query,
+    DocumentPredicate document_predicate,
+    size_t max_count) const {
 
-    const Query query = ParseQuery(raw_query);
-    std::vector<Document> matched_docs = FindAllDocuments(query, document_predicate);
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate, max_count);
+}
 
-    std::sort(matched_docs.begin(), matched_docs.end(),
-        [](const Document& lhs, const Document& rhs) {
-            if (std::abs(lhs.relevance - rhs.relevance) < EPSILON) {
-                return lhs.rating > rhs.rating;
-            }
-            return lhs.relevance > rhs.relevance;
-        });
-    if (matched_docs.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_docs.resize(MAX_RESULT_DOCUMENT_COUNT);
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& policy,
+    std::string_view raw_query,
+    DocumentPredicate document_predicate,
+    size_t max_count) const {
+
+    const QueryScope scope;
+    return FindTopDocuments(policy, ParseQuery(raw_query, true, scope.GetResource()), std::nullopt, document_predicate, max_count);
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& policy,
+    std::string_view raw_query,
+    const DocumentStatus status,
+    size_t max_count) const {
+
+    const QueryScope scope;
+    const Query query = ParseQuery(raw_query, true, scope.GetResource());
+    const std::pmr::string cache_key = BuildQueryCacheKey(query,
+        std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>, status, max_count);
+    if (std::optional<std::vector<Document>> cached_docs = query_cache_.Find(cache_key, generation_)) {
+        return std::move(*cached_docs);
     }
+
+    std::vector<Document> matched_docs = FindTopDocuments(policy, query, status, [](int, DocumentStatus, int) {
+        return true; },
+        max_count);
+    query_cache_.Insert(cache_key, generation_, matched_docs);
     return matched_docs;
 }
 
-template <typename predicat>
-std::vector<Document> SearchServer::FindAllDocuments(const Query& query, predicat comp) const {
-    std::map<int, double> document_to_relevance;
-    for (const std::string& word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(const Query& query,
+    DocumentPredicate document_predicate,
+    size_t max_count) const {
+
+    return FindTopDocuments(std::execution::seq, query, std::nullopt, document_predicate, max_count);
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& policy,
+    const Query& query,
+    std::optional<DocumentStatus> status,
+    DocumentPredicate document_predicate,
+    size_t max_count) const {
+
+    return VisitScorer(query, [&](const auto& scorer) {
+        if constexpr (std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>) {
+            if (query.plus_words.size() > 1) {
+                std::vector<Document> top_documents(std::min(max_count, CountPostings(query)));
+                top_documents.resize(FindTopDocumentsPruned(scorer, query, status, document_predicate, top_documents));
+                return top_documents;
+            }
+        }
+
+        std::vector<Document> matched_docs = FindAllDocuments(policy, scorer, query, status, document_predicate);
+        SelectTopDocuments(policy, matched_docs, max_count);
+        return matched_docs;
+    });
+}
+
+template <typename Function>
+auto SearchServer::VisitScorer(const Query& query, Function function) const {
+    if (const CollectionStatistics* statistics = query.statistics) {
+        if (scoring_model_ == ScoringModel::BM25) {
+            const double average_length = statistics->document_count > 0
+                ? static_cast<double>(statistics->total_document_length) / statistics->document_count : 0.0;
+            return function(Bm25Scorer(statistics->document_count, average_length));
+        }
+        return function(TfIdfScorer(std::log(static_cast<double>(statistics->document_count))));
+    }
+
+    if (scoring_model_ == ScoringModel::BM25) {
+        return function(Bm25Scorer(static_cast<size_t>(document_count_), GetAverageDocumentLength()));
+    }
+    return function(TfIdfScorer(log_document_count_));
+}
+
+template <typename Scorer>
+double SearchServer::ComputeTermWeight(const Scorer& scorer, const Query& query, int term_id) const {
+    if (query.statistics) {
+        const size_t document_freq = query.statistics->GetDocumentFreq(index_.GetTerm(term_id));
+        return scorer.ComputeTermWeight(std::log(static_cast<double>(document_freq)), document_freq);
+    }
+    return scorer.ComputeTermWeight(index_.GetLogDocumentFreq(term_id), index_.GetPostings(term_id).size());
+}
+
+template <typename Scorer>
+std::vector<SearchServer::PostingRange> SearchServer::SplitPlusWordsPostings(const Scorer& scorer, const Query& query) const {
+    std::vector<PostingRange> ranges;
+    for (const std::string_view word : query.plus_words) {
+        const int term_id = index_.FindTerm(word);
+        if (term_id == InvertedIndex::NO_TERM) {
             continue;
         }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (const auto& [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-            document_to_relevance[document_id] += term_freq * inverse_document_freq;
+        const double term_weight = ComputeTermWeight(scorer, query, term_id);
+        const PostingList& postings = index_.GetPostings(term_id);
+        const size_t blocks_per_range = posting_range_size_ / PostingList::BLOCK_SIZE;
+        for (size_t start = 0; start < postings.GetBlockCount(); start += blocks_per_range) {
+            const size_t end = std::min(start + blocks_per_range, postings.GetBlockCount());
+            ranges.push_back({ &postings, start, end, term_weight });
         }
     }
+    return ranges;
+}
+
+template <typename Words>
+void SearchServer::RemoveDuplicateWords(Words& words) {
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+}
 
-    for (const std::string& word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+template <typename ExecutionPolicy>
+void SearchServer::SelectTopDocuments(const ExecutionPolicy& policy,
+    std::vector<Document>& documents, size_t max_count) {
+
+    if (documents.size() <= max_count) {
+        std::sort(policy, documents.begin(), documents.end(), IsMoreRelevant);
+        return;
+    }
+
+    std::partial_sort(policy, documents.begin(), documents.begin() + max_count, documents.end(), IsMoreRelevant);
+    documents.resize(max_count);
+}
+
+template <typename Scorer, typename DocumentPredicate>
+size_t SearchServer::FindTopDocumentsPruned(const Scorer& scorer, const Query& query, std::optional<DocumentStatus> status,
+    DocumentPredicate document_predicate, std::span<Document> output) const {
+
+    std::pmr::vector<ScoredTerm> terms(query.GetResource());
+    for (const std::string_view word : query.plus_words) {
+        const int term_id = index_.FindTerm(word);
+        if (term_id == InvertedIndex::NO_TERM || index_.GetPostings(term_id).empty()) {
             continue;
         }
-        for (const auto& [document_id, _] : word_to_document_freqs_.at(word)) {
-            document_to_relevance.erase(document_id);
+        const PostingList& postings = index_.GetPostings(term_id);
+        const double term_weight = ComputeTermWeight(scorer, query, term_id);
+        terms.push_back({ &postings, term_weight, ComputeUpperBound(scorer, term_weight, postings) });
+    }
+
+    std::pmr::vector<const PostingList*> excluded_postings(query.GetResource());
+    for (const std::string_view word : query.minus_words) {
+        const int term_id = index_.FindTerm(word);
+        if (term_id != InvertedIndex::NO_TERM) {
+            excluded_postings.push_back(&index_.GetPostings(term_id));
+        }
+    }
+
+    const size_t count = RetrieveTopDocuments(scorer, terms, excluded_postings, output, 2 * EPSILON,
+        [this, &query, status, &document_predicate](int document_number) -> std::optional<int> {
+            const DocumentData& data = documents_[document_number];
+            if (!HasStatus(document_number, status) || !document_predicate(data.id, data.status, data.rating)
+                || !MatchesPositionalConstraints(query, document_number)) {
+                return std::nullopt;
+            }
+            return data.rating;
+        },
+        IsMoreRelevant, query.GetResource());
+    for (Document& document : output.first(count)) {
+        document.id = documents_[document.id].id;
+    }
+    return count;
+}
+
+template <typename Scorer, typename predicat>
+std::vector<Document> SearchServer::FindAllDocuments(const std::execution::sequenced_policy&, const Scorer& scorer,
+    const Query& query, std::optional<DocumentStatus> status, predicat comp) const {
+    const DocumentIdSet excluded_documents = BuildExcludedDocuments(query);
+    const auto accumulate = [&](auto add_relevance) {
+        for (const std::string_view word : query.plus_words) {
+            const int term_id = index_.FindTerm(word);
+            if (term_id == InvertedIndex::NO_TERM) {
+                continue;
+            }
+            const double term_weight = ComputeTermWeight(scorer, query, term_id);
+            index_.GetPostings(term_id).ForEach([&](const RawPosting& posting) {
+                if (HasStatus(posting.document_id, status) && !excluded_documents.Contains(posting.document_id)) {
+                    add_relevance(posting.document_id, scorer.ComputeScore(term_weight, posting.term_count, posting.document_length));
+                }
+            });
+        }
+    };
+
+    DenseAccumulator& dense_accumulator = GetDenseAccumulator();
+    if (IsDocumentNumberRangeDense() && !dense_accumulator.IsInUse()) {
+        std::vector<Document> matched_documents;
+        {
+            const DenseAccumulator::Lease lease(dense_accumulator, documents_.size());
+            accumulate([&dense_accumulator](int document_number, double relevance) {
+                dense_accumulator.Add(document_number, relevance);
+            });
+            for (const int number : dense_accumulator.GetSortedTouched()) {
+                matched_documents.push_back({ number, dense_accumulator.Get(number), documents_[number].rating });
+            }
+        }
+
+        std::erase_if(matched_documents, [this, &query, &comp](const Document& document) {
+            const DocumentData& data = documents_[document.id];
+            return !comp(data.id, data.status, data.rating) || !MatchesPositionalConstraints(query, document.id);
+        });
+        for (Document& document : matched_documents) {
+            document.id = documents_[document.id].id;
         }
+        return matched_documents;
     }
 
+    std::pmr::map<int, double> document_to_relevance(query.GetResource());
+    accumulate([&document_to_relevance](int document_number, double relevance) {
+        document_to_relevance[document_number] += relevance;
+    });
+
     std::vector<Document> matched_documents;
-    for (const auto& [id, relevance] : document_to_relevance) {
-        if (comp(id, documents_.at(id).status, documents_.at(id).rating)) {
-            matched_documents.push_back({ id, relevance, documents_.at(id).rating });
+    for (const auto& [number, relevance] : document_to_relevance) {
+        const DocumentData& data = documents_[number];
+        if (comp(data.id, data.status, data.rating) && MatchesPositionalConstraints(query, number)) {
+            matched_documents.push_back({ data.id, relevance, data.rating });
         }
     }
 
     return matched_documents;
-}
\ No newline at end of file
+}
+
+template <typename Scorer, typename predicat>
+std::vector<Document> SearchServer::FindAllDocuments(const std::execution::parallel_policy& policy, const Scorer& scorer,
+    const Query& query, std::optional<DocumentStatus> status, predicat comp) const {
+    const DocumentIdSet excluded_documents = BuildExcludedDocuments(query);
+    ConcurrentMap<int, double> document_to_relevance(relevance_bucket_count_);
+
+    const std::vector<PostingRange> ranges = SplitPlusWordsPostings(scorer, query);
+    std::for_each(policy, ranges.begin(), ranges.end(),
+        [this, &scorer, status, &document_to_relevance, &excluded_documents](const PostingRange& range) {
+            for (PostingCursor cursor(*range.postings, range.first_block, range.end_block); !cursor.IsEnd(); cursor.Next()) {
+                const RawPosting& posting = cursor.GetPosting();
+                if (HasStatus(posting.document_id, status) && !excluded_documents.Contains(posting.document_id)) {
+                    document_to_relevance[posting.document_id].ref_to_value
+                        += scorer.ComputeScore(range.term_weight, posting.term_count, posting.document_length);
+                }
+            }
+        });
+
+    std::vector<Document> matched_documents;
+    for (const auto& [number, relevance] : document_to_relevance.BuildOrdinaryMap()) {
+        const DocumentData& data = documents_[number];
+        if (comp(data.id, data.status, data.rating) && MatchesPositionalConstraints(query, number)) {
+            matched_documents.push_back({ data.id, relevance, data.rating });
+        }
+    }
+
+    return matched_documents;
+}
+
+inline bool SearchServer::HasStatus(int document_number, std::optional<DocumentStatus> status) const {
+    return !status || documents_[document_number].status == *status;
+}
@@ -2,8 +2,24 @@
 #include<iostream>
 #include<vector>
 #include<stdexcept>
+#include<random>
+#include<numeric>
+#include<algorithm>
+#include<execution>
+#include<atomic>
+#include<thread>
 #include "search_server_tests.h"
 #include "search_server.h"
+#include "process_queries.h"
+#include "concurrent_map.h"
+#include "remove_duplicates.h"
+#include "posting_list.h"
+#include "document_id_set.h"
+#include "request_queue.h"
+#include "segmented_search_server.h"
+#include "rcu_search_server.h"
+#include "query_context.h"
+#include "index_snapshot.h"
 
 using namespace std;
 
@@ -179,7 +195,7 @@ void TestMatchingDocuments() {
     auto& status = get<1>(matched_docs);
     set<string> matched_words;
     for (const auto& word : words) {
-        matched_words.insert(word);
+        matched_words.insert(string(word));
     }
     const set<string> expected_matched_words = { "lazy"s, "dog"s, "brown"s };
 
@@ -199,6 +215,1066 @@ void TestGettingDocumentCount() {
     server.AddDocument(2, "ho ho ho ho"s, DocumentStatus::ACTUAL, { 1 });
     ASSERT_EQUAL(server.GetDocumentCount(), 2);
 }
+void TestIndexWithUnorderedDocumentIds() {
+    SearchServer server(""s);
+    server.AddDocument(5, "cat dog"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(1, "cat cat parrot"s, DocumentStatus::ACTUAL, { 2 });
+    server.AddDocument(3, "dog"s, DocumentStatus::ACTUAL, { 3 });
+    {
+        auto found_docs = server.FindTopDocuments("cat"s);
+        ASSERT_EQUAL(found_docs.size(), 2u);
+        ASSERT_EQUAL(found_docs[0].id, 1);
+        ASSERT(EqualFloat(found_docs[0].relevance, log(3.0 / 2.0) * 2.0 / 3.0));
+        ASSERT_EQUAL(found_docs[1].id, 5);
+    }
+    {
+        auto found_docs = server.FindTopDocuments("dog -parrot"s);
+        ASSERT_EQUAL(found_docs.size(), 2u);
+        ASSERT_EQUAL(found_docs[0].id, 3);
+        ASSERT_EQUAL(found_docs[1].id, 5);
+    }
+    {
+        auto [words, status] = server.MatchDocument("parrot dog cat"s, 1);
+        ASSERT_EQUAL(words.size(), 2u);
+        ASSERT_EQUAL(words[0], "cat"s);
+        ASSERT_EQUAL(words[1], "parrot"s);
+    }
+}
+void TestParallelFindTopDocuments() {
+    SearchServer server("and with"s);
+    const vector<string> words = { "white"s, "cat"s, "fluffy"s, "dog"s, "tail"s, "collar"s, "parrot"s, "eyes"s };
+    for (int id = 0; id < 10000; ++id) {
+        string text;
+        for (int i = 0; i <= id % 5; ++i) {
+            text += words[(id * 7 + i * 3) % words.size()] + " "s;
+        }
+        server.AddDocument(id, text, static_cast<DocumentStatus>(id % 4), { id % 11 - 5 });
+    }
+
+    for (const string& query : { "cat"s, "fluffy cat -collar"s, "white dog eyes -tail"s, "sparrow"s }) {
+        const auto seq_docs = server.FindTopDocuments(execution::seq, query);
+        const auto par_docs = server.FindTopDocuments(execution::par, query);
+        ASSERT_EQUAL(seq_docs.size(), par_docs.size());
+        for (size_t i = 0; i < seq_docs.size(); ++i) {
+            ASSERT(EqualFloat(seq_docs[i].relevance, par_docs[i].relevance));
+            ASSERT_EQUAL(seq_docs[i].rating, par_docs[i].rating);
+        }
+
+        const auto par_banned = server.FindTopDocuments(execution::par, query, DocumentStatus::BANNED);
+        const auto seq_banned = server.FindTopDocuments(query, DocumentStatus::BANNED);
+        ASSERT_EQUAL(seq_banned.size(), par_banned.size());
+
+        const auto par_even = server.FindTopDocuments(execution::par, query,
+            [](int document_id, DocumentStatus, int) { return document_id % 2 == 0; });
+        for (const Document& document : par_even) {
+            ASSERT_EQUAL(document.id % 2, 0);
+        }
+    }
+}
+void TestProcessQueries() {
+    SearchServer server("and with"s);
+    server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, { 1, 2, 3 });
+    server.AddDocument(3, "big cat nasty hair"s, DocumentStatus::ACTUAL, { 1, 2, 8 });
+    server.AddDocument(4, "big dog cat Vladislav"s, DocumentStatus::ACTUAL, { 1, 3, 2 });
+    server.AddDocument(5, "big dog hamster Borya"s, DocumentStatus::ACTUAL, { 1, 1, 1 });
+
+    const vector<string> queries = { "nasty rat -not"s, "not very funny nasty pet"s, "curly hair"s, "sparrow"s };
+    const auto documents_lists = ProcessQueries(server, queries);
+    ASSERT_EQUAL(documents_lists.size(), queries.size());
+    ASSERT_EQUAL(documents_lists[0].size(), 2u);
+    ASSERT_EQUAL(documents_lists[1].size(), 3u);
+    ASSERT_EQUAL(documents_lists[2].size(), 2u);
+    ASSERT(documents_lists[3].empty());
+
+    const auto joined_documents = ProcessQueriesJoined(server, queries);
+    ASSERT_EQUAL(joined_documents.size(), 7u);
+    ASSERT_EQUAL(server.GetQueryCache().GetMissCount(), 0u);
+    size_t position = 0;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const vector<Document> expected = server.FindTopDocuments(queries[i]);
+        ASSERT_EQUAL(documents_lists[i].size(), expected.size());
+        for (const Document& document : expected) {
+            ASSERT_EQUAL(joined_documents[position++].id, document.id);
+        }
+    }
+
+    for (const string& query : { "nasty"s, "funny nasty pet"s }) {
+        const vector<Document> expected = server.FindTopDocuments(query, DocumentStatus::ACTUAL, 2);
+        Document output[2];
+        ASSERT_EQUAL(server.FindTopDocuments(query, span<Document>(output)), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_EQUAL(output[i].id, expected[i].id);
+        }
+    }
+}
+void TestFindTopDocumentsMaxCount() {
+    SearchServer server(""s);
+    for (int id = 0; id < 20; ++id) {
+        server.AddDocument(id, "cat"s + string(id % 4 + 1, 's') + " cat dog"s, DocumentStatus::ACTUAL, { id });
+    }
+    const auto all_docs = server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 100);
+    ASSERT_EQUAL(all_docs.size(), 20u);
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s).size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT));
+    ASSERT(server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 0).empty());
+
+    for (size_t max_count : { 1u, 3u, 7u }) {
+        const auto top_docs = server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, max_count);
+        const auto par_docs = server.FindTopDocuments(execution::par, "cat"s,
+            [](int, DocumentStatus, int) { return true; }, max_count);
+        ASSERT_EQUAL(top_docs.size(), max_count);
+        ASSERT_EQUAL(par_docs.size(), max_count);
+        for (size_t i = 0; i < max_count; ++i) {
+            ASSERT_EQUAL(top_docs[i].id, all_docs[i].id);
+            ASSERT_EQUAL(par_docs[i].id, all_docs[i].id);
+        }
+    }
+}
+void TestStringViewQueries() {
+    SearchServer server("and in"s);
+    {
+        string document = "fluffy cat and fluffy tail"s;
+        server.AddDocument(1, string_view(document).substr(7), DocumentStatus::ACTUAL, { 1 });
+        document.assign(document.size(), 'x');
+    }
+    server.AddDocument(2, "  groomed   dog  "sv, DocumentStatus::ACTUAL, { 2 });
+
+    const string raw_queries = "cat tail -groomed dog -"s;
+    const string_view queries = raw_queries;
+    {
+        const auto found_docs = server.FindTopDocuments(queries.substr(0, 8));
+        ASSERT_EQUAL(found_docs.size(), 1u);
+        ASSERT_EQUAL(found_docs[0].id, 1);
+    }
+    {
+        const auto found_docs = server.FindTopDocuments(queries.substr(18, 3));
+        ASSERT_EQUAL(found_docs.size(), 1u);
+        ASSERT_EQUAL(found_docs[0].id, 2);
+    }
+    {
+        const auto [words, status] = server.MatchDocument(queries.substr(0, 8), 1);
+        ASSERT_EQUAL(words.size(), 2u);
+        ASSERT_EQUAL(words[0], "cat"s);
+        ASSERT_EQUAL(words[1], "tail"s);
+    }
+    AssertExeptionHintNegative([&server, queries]() { server.FindTopDocuments(queries.substr(0, 10)); },
+        "Empty minus at the end of query view is passed"s);
+    AssertExeptionHintNegative([&server, queries]() { server.FindTopDocuments(queries); },
+        "Empty minus at the end of query is passed"s);
+}
+void TestRemoveDocument() {
+    SearchServer server("and with"s);
+    server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, { 1, 2 });
+    server.AddDocument(3, "funny pet and not very nasty rat"s, DocumentStatus::ACTUAL, { 1, 3, 2 });
+    server.AddDocument(4, "pet with rat and rat and rat"s, DocumentStatus::ACTUAL, { 1, 2 });
+
+    const auto& word_freqs = server.GetWordFrequencies(4);
+    ASSERT_EQUAL(word_freqs.size(), 2u);
+    ASSERT(EqualFloat(word_freqs.at("pet"sv), 0.25));
+    ASSERT(EqualFloat(word_freqs.at("rat"sv), 0.75));
+    ASSERT(server.GetWordFrequencies(5).empty());
+
+    server.RemoveDocument(3);
+    ASSERT_EQUAL(server.GetDocumentCount(), 3);
+    ASSERT(server.GetWordFrequencies(3).empty());
+    ASSERT_EQUAL(server.FindTopDocuments("nasty"s).size(), 1u);
+    ASSERT_EQUAL(server.FindTopDocuments("rat"s).size(), 2u);
+    AssertExeptionHintNegative([&server]() { server.MatchDocument("rat"s, 3); }, "Removed document is matched"s);
+
+    server.RemoveDocument(execution::par, 1);
+    server.RemoveDocument(execution::seq, 2);
+    server.RemoveDocument(42);
+    ASSERT_EQUAL(server.GetDocumentCount(), 1);
+    ASSERT_EQUAL(server.GetDocumentId(0), 4);
+    ASSERT(vector<int>(server.begin(), server.end()) == vector<int>{ 4 });
+
+    SearchServer ordered_server(""s);
+    for (const int id : { 5, 2, 9, 7 }) {
+        ordered_server.AddDocument(id, "cat"s, DocumentStatus::ACTUAL, {});
+    }
+    ASSERT_EQUAL(ordered_server.GetDocumentId(0), 5);
+    ordered_server.RemoveDocument(2);
+    ordered_server.RemoveDocument(7);
+    ASSERT_EQUAL(ordered_server.GetDocumentId(1), 9);
+    ordered_server.AddDocument(2, "dog"s, DocumentStatus::ACTUAL, {});
+    ASSERT_EQUAL(ordered_server.GetDocumentId(2), 2);
+    AssertExeptionHintNegative([&ordered_server]() { ordered_server.GetDocumentId(3); },
+        "Index past the live documents is accepted"s);
+    ASSERT(vector<int>(ordered_server.begin(), ordered_server.end()) == vector<int>({ 2, 5, 9 }));
+    ASSERT(server.FindTopDocuments("funny nasty"s).empty());
+
+    const auto found_docs = server.FindTopDocuments("pet"s);
+    ASSERT_EQUAL(found_docs.size(), 1u);
+    ASSERT_EQUAL(found_docs[0].id, 4);
+
+    server.AddDocument(1, "funny rat"s, DocumentStatus::ACTUAL, { 5 });
+    ASSERT_EQUAL(server.FindTopDocuments("funny"s).size(), 1u);
+}
+void TestParallelMatchDocument() {
+    SearchServer server("and with"s);
+    server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::BANNED, { 1, 2 });
+
+    const string query = "curly and funny -not pet curly funny"s;
+    {
+        const auto [words, status] = server.MatchDocument(execution::par, query, 2);
+        ASSERT_EQUAL(words.size(), 3u);
+        ASSERT_EQUAL(words[0], "curly"sv);
+        ASSERT_EQUAL(words[1], "funny"sv);
+        ASSERT_EQUAL(words[2], "pet"sv);
+        ASSERT_EQUAL(status, DocumentStatus::BANNED);
+
+        const auto [seq_words, seq_status] = server.MatchDocument(execution::seq, query, 2);
+        ASSERT_EQUAL(seq_words.size(), words.size());
+        for (size_t i = 0; i < words.size(); ++i) {
+            ASSERT_EQUAL(seq_words[i], words[i]);
+            ASSERT_EQUAL(seq_words[i].data(), words[i].data());
+        }
+    }
+    {
+        const auto [words, status] = server.MatchDocument(execution::par, "funny -rat"s, 1);
+        ASSERT(words.empty());
+        ASSERT_EQUAL(status, DocumentStatus::ACTUAL);
+    }
+    AssertExeptionHintNegative([&server]() { server.MatchDocument(execution::par, "funny"s, 3); },
+        "Missing document is matched"s);
+    AssertExeptionHintNegative([&server]() { server.MatchDocument(execution::par, "funny --pet"s, 1); },
+        "Double minus in query is passed"s);
+}
+void TestConcurrentMap() {
+    ConcurrentMap<int, int> counters(7);
+    vector<int> keys(10000);
+    for (int i = 0; i < static_cast<int>(keys.size()); ++i) {
+        keys[i] = i % 100 - 50;
+    }
+    for_each(execution::par, keys.begin(), keys.end(), [&counters](int key) {
+        ++counters[key].ref_to_value;
+    });
+    counters.Erase(0);
+
+    const map<int, int> result = counters.BuildOrdinaryMap();
+    ASSERT_EQUAL(result.size(), 99u);
+    ASSERT_EQUAL(result.begin()->first, -50);
+    ASSERT_EQUAL(result.count(0), 0u);
+    for (const auto& [key, count] : result) {
+        ASSERT_EQUAL(count, 100);
+    }
+}
+void TestRemoveDuplicates() {
+    SearchServer server("and with"s);
+    server.AddDocument(9, "funny pet and curly hair"s, DocumentStatus::ACTUAL, { 1, 2 });
+    server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, { 1, 2 });
+    server.AddDocument(3, "funny pet with curly hair"s, DocumentStatus::ACTUAL, { 1, 2 });
+    server.AddDocument(4, "funny pet and curly hair hair"s, DocumentStatus::ACTUAL, { 1, 2 });
+    server.AddDocument(5, "funny funny pet and nasty nasty rat"s, DocumentStatus::ACTUAL, { 1, 2 });
+    server.AddDocument(6, "funny pet and not very nasty rat"s, DocumentStatus::ACTUAL, { 1, 2 });
+    server.AddDocument(7, "very nasty rat and not very funny pet"s, DocumentStatus::ACTUAL, { 1, 2 });
+    server.AddDocument(8, "pet with rat and rat and rat"s, DocumentStatus::ACTUAL, { 1, 2 });
+    server.AddDocument(1, "nasty rat with curly hair"s, DocumentStatus::ACTUAL, { 1, 2 });
+
+    RemoveDuplicates(server);
+    ASSERT_EQUAL(server.GetDocumentCount(), 5);
+
+    vector<int> document_ids(server.begin(), server.end());
+    sort(document_ids.begin(), document_ids.end());
+    const vector<int> expected_ids = { 1, 2, 5, 6, 8 };
+    ASSERT_EQUAL(document_ids.size(), expected_ids.size());
+    AssertEqualElementsContainers(document_ids, expected_ids, "document_ids"s, "expected_ids"s);
+}
+void TestSaveAndLoadIndex() {
+    const string path = "search_server_index.bin"s;
+    SearchServer server("and with"s);
+    server.AddDocument(4, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::BANNED, { 1, 2 });
+    server.AddDocument(7, "big cat nasty hair"s, DocumentStatus::ACTUAL, { -3 });
+    server.AddDocument(1, "rat rat rat"s, DocumentStatus::ACTUAL, {});
+    server.SaveIndex(path);
+
+    SearchServer loaded_server(""s);
+    loaded_server.AddDocument(100, "stale document"s, DocumentStatus::ACTUAL, { 1 });
+    loaded_server.LoadIndex(path);
+    remove(path.c_str());
+
+    ASSERT_EQUAL(loaded_server.GetDocumentCount(), server.GetDocumentCount());
+    for (int index = 0; index < server.GetDocumentCount(); ++index) {
+        ASSERT_EQUAL(loaded_server.GetDocumentId(index), server.GetDocumentId(index));
+    }
+    ASSERT(loaded_server.FindTopDocuments("stale"s).empty());
+    ASSERT(loaded_server.FindTopDocuments("and"s).empty());
+
+    for (const string& query : { "funny nasty rat"s, "curly hair -rat"s, "cat"s }) {
+        const auto expected_docs = server.FindTopDocuments(query);
+        const auto loaded_docs = loaded_server.FindTopDocuments(query);
+        ASSERT_EQUAL(loaded_docs.size(), expected_docs.size());
+        for (size_t i = 0; i < expected_docs.size(); ++i) {
+            ASSERT_EQUAL(loaded_docs[i].id, expected_docs[i].id);
+            ASSERT_EQUAL(loaded_docs[i].rating, expected_docs[i].rating);
+            ASSERT(EqualFloat(loaded_docs[i].relevance, expected_docs[i].relevance));
+        }
+    }
+    ASSERT_EQUAL(get<1>(loaded_server.MatchDocument("hair"s, 2)), DocumentStatus::BANNED);
+    ASSERT(EqualFloat(loaded_server.GetWordFrequencies(1).at("rat"sv), 1.0));
+
+    loaded_server.RemoveDocument(4);
+    ASSERT_EQUAL(loaded_server.FindTopDocuments("funny"s, DocumentStatus::BANNED).size(), 1u);
+    ASSERT(loaded_server.FindTopDocuments("funny"s).empty());
+
+    AssertExeptionHintNegative([&loaded_server]() { loaded_server.LoadIndex("missing_index.bin"s); },
+        "Missing snapshot is loaded"s);
+    ASSERT_EQUAL(loaded_server.GetDocumentCount(), 3);
+
+    SearchServer corrupted_server(""s);
+    corrupted_server.AddDocument(1, "cat"s, static_cast<DocumentStatus>(7), { 1 });
+    corrupted_server.SaveIndex(path);
+    AssertExeptionHintNegative([&loaded_server, &path]() { loaded_server.LoadIndex(path); },
+        "Snapshot with an unknown document status is loaded"s);
+    remove(path.c_str());
+    ASSERT_EQUAL(loaded_server.GetDocumentCount(), 3);
+
+    const auto write_snapshot = [&path](const vector<int32_t>& posting_numbers) {
+        SnapshotWriter writer(path);
+        writer.WriteStrings({});
+        writer.WriteStrings({ "cat"sv });
+        writer.WriteArray(vector<uint64_t>{ 0, posting_numbers.size() });
+        writer.WriteArray(posting_numbers);
+        writer.WriteArray(vector<uint32_t>(posting_numbers.size(), 1));
+        writer.WriteArray(vector<uint32_t>(posting_numbers.size(), 1));
+        writer.Write<uint32_t>(0);
+        writer.WriteArray(vector<uint64_t>{});
+        writer.WriteArray(vector<int32_t>{});
+        writer.WriteArray(vector<uint64_t>{});
+        writer.WriteArray(vector<uint32_t>{});
+        writer.WriteArray(vector<int32_t>{ 10, 20 });
+        writer.WriteArray(vector<int32_t>{ 1, 2 });
+        writer.WriteArray(vector<int32_t>{ 0, 0 });
+        writer.WriteArray(vector<uint32_t>{ 1, 1 });
+        writer.Finish();
+    };
+    write_snapshot({ 0, 1 });
+    loaded_server.LoadIndex(path);
+    ASSERT_EQUAL(loaded_server.FindTopDocuments("cat"s).size(), 2u);
+    for (const vector<int32_t>& posting_numbers : vector<vector<int32_t>>{ { 1, 0 }, { 0, 0 }, { -1, 1 } }) {
+        write_snapshot(posting_numbers);
+        bool is_rejected = false;
+        try {
+            loaded_server.LoadIndex(path);
+        }
+        catch (const invalid_argument&) {
+            is_rejected = true;
+        }
+        ASSERT_HINT(is_rejected, "Snapshot with unordered document numbers is loaded"s);
+    }
+    remove(path.c_str());
+    ASSERT_EQUAL(loaded_server.GetDocumentCount(), 2);
+}
+void TestInverseDocumentFreqIsUpdated() {
+    SearchServer server(""s);
+    server.AddDocument(0, "cat"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(2, "parrot"s, DocumentStatus::ACTUAL, { 1 });
+    {
+        const auto found_docs = server.FindTopDocuments("cat"s);
+        ASSERT_EQUAL(found_docs.size(), 2u);
+        ASSERT(EqualFloat(found_docs[0].relevance, log(3.0 / 2.0)));
+    }
+
+    server.AddDocument(3, "dog"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(4, "dog dog"s, DocumentStatus::ACTUAL, { 1 });
+    {
+        const auto found_docs = server.FindTopDocuments("cat"s);
+        ASSERT(EqualFloat(found_docs[0].relevance, log(5.0 / 2.0)));
+        const auto dog_docs = server.FindTopDocuments("dog"s);
+        ASSERT_EQUAL(dog_docs.size(), 3u);
+        ASSERT(EqualFloat(dog_docs[0].relevance, log(5.0 / 3.0)));
+    }
+
+    server.RemoveDocument(1);
+    server.RemoveDocument(4);
+    {
+        const auto found_docs = server.FindTopDocuments("cat"s);
+        ASSERT_EQUAL(found_docs.size(), 1u);
+        ASSERT(EqualFloat(found_docs[0].relevance, log(3.0)));
+        const auto dog_docs = server.FindTopDocuments(execution::par, "dog"s);
+        ASSERT_EQUAL(dog_docs.size(), 1u);
+        ASSERT(EqualFloat(dog_docs[0].relevance, log(3.0)));
+    }
+}
+void TestPrunedTopDocumentsMatchExhaustiveSearch() {
+    mt19937 generator(42);
+    vector<string> dictionary;
+    for (int i = 0; i < 40; ++i) {
+        dictionary.push_back("word"s + to_string(i));
+    }
+    const auto random_word = [&generator, &dictionary]() {
+        const int index = uniform_int_distribution<int>(0, static_cast<int>(dictionary.size() - 1))(generator);
+        return dictionary[index * index / static_cast<int>(dictionary.size())];
+    };
+
+    SearchServer server(""s);
+    for (int i = 0; i < 3000; ++i) {
+        const int id = (i * 7919) % 3000;
+        string document;
+        const int word_count = uniform_int_distribution<int>(1, 12)(generator);
+        for (int j = 0; j < word_count; ++j) {
+            document += random_word() + " "s;
+        }
+        server.AddDocument(id, document, static_cast<DocumentStatus>(id % 3), { uniform_int_distribution<int>(-3, 3)(generator) });
+    }
+    for (int id = 0; id < 3000; id += 11) {
+        server.RemoveDocument(id);
+    }
+
+    for (int i = 0; i < 200; ++i) {
+        string query;
+        const int word_count = uniform_int_distribution<int>(2, 6)(generator);
+        for (int j = 0; j < word_count; ++j) {
+            query += (j > 0 && j % 3 == 0 ? "-"s : ""s) + random_word() + " "s;
+        }
+        const size_t max_count = i % 3 == 0 ? 1 : i % 3 == 1 ? MAX_RESULT_DOCUMENT_COUNT : 40;
+
+        for (const ScoringModel scoring_model : { ScoringModel::TF_IDF, ScoringModel::BM25 }) {
+            server.SetScoringModel(scoring_model);
+            const auto pruned_docs = server.FindTopDocuments(query, DocumentStatus::ACTUAL, max_count);
+            const auto expected_docs = server.FindTopDocuments(execution::par, query, DocumentStatus::ACTUAL, max_count);
+            ASSERT_EQUAL(pruned_docs.size(), expected_docs.size());
+            for (size_t j = 0; j < expected_docs.size(); ++j) {
+                ASSERT(EqualFloat(pruned_docs[j].relevance, expected_docs[j].relevance));
+                ASSERT_EQUAL(pruned_docs[j].rating, expected_docs[j].rating);
+            }
+        }
+    }
+}
+void TestDocumentIdSet() {
+    DocumentIdSet documents;
+    for (int document_id = 0; document_id < 20000; document_id += 3) {
+        documents.Insert(document_id);
+    }
+    documents.Insert(70000);
+    documents.Insert(5);
+    documents.Insert(5);
+    documents.Insert(3);
+
+    ASSERT_EQUAL(documents.size(), 6669u);
+    ASSERT(documents.Contains(0));
+    ASSERT(documents.Contains(5));
+    ASSERT(documents.Contains(19998));
+    ASSERT(documents.Contains(70000));
+    ASSERT(!documents.Contains(1));
+    ASSERT(!documents.Contains(20001));
+    ASSERT(!documents.Contains(65536));
+    ASSERT(!DocumentIdSet().Contains(0));
+}
+void TestDenseAccumulatorMatchesSparseSearch() {
+    const vector<string> texts = {
+        "white cat and fashionable collar"s,
+        "fluffy cat fluffy tail"s,
+        "groomed dog expressive eyes"s,
+        "groomed starling evgeny"s,
+        "cat with collar"s,
+    };
+    SearchServer dense_server("and with"s);
+    SearchServer sparse_server("and with"s);
+    for (int i = 0; i < static_cast<int>(texts.size()); ++i) {
+        dense_server.AddDocument(i, texts[i], DocumentStatus::ACTUAL, { i });
+        sparse_server.AddDocument(i * 1000, texts[i], DocumentStatus::ACTUAL, { i });
+    }
+
+    const vector<Document> dense_docs = dense_server.FindTopDocuments("cat -collar"s);
+    const vector<Document> sparse_docs = sparse_server.FindTopDocuments("cat -collar"s);
+    ASSERT_EQUAL(dense_docs.size(), 1u);
+    ASSERT_EQUAL(dense_docs.size(), sparse_docs.size());
+    ASSERT_EQUAL(dense_docs[0].id * 1000, sparse_docs[0].id);
+    ASSERT(EqualFloat(dense_docs[0].relevance, sparse_docs[0].relevance));
+
+    const vector<Document> nested_docs = dense_server.FindTopDocuments("groomed"s,
+        [&dense_server](int document_id, DocumentStatus, int) {
+            return dense_server.FindTopDocuments("groomed"s).size() == 2u && document_id == 3;
+        });
+    ASSERT_EQUAL(nested_docs.size(), 1u);
+    ASSERT_EQUAL(nested_docs[0].id, 3);
+
+    DenseAccumulator accumulator;
+    try {
+        const DenseAccumulator::Lease lease(accumulator, 8);
+        accumulator.Add(5, 1.0);
+        throw runtime_error("interrupted query"s);
+    }
+    catch (const runtime_error&) {
+    }
+    ASSERT(!accumulator.IsInUse());
+    ASSERT(EqualFloat(accumulator.Get(5), 0.0));
+}
+void TestStatusFilterSkipsOtherDocuments() {
+    const string path = "search_server_status_index.bin"s;
+    SearchServer server("and with"s);
+    server.AddDocument(1000, "white cat and fashionable collar"s, DocumentStatus::ACTUAL, { 8 });
+    server.AddDocument(5, "fluffy cat fluffy tail"s, DocumentStatus::BANNED, { 7 });
+    server.AddDocument(70, "groomed cat expressive eyes"s, DocumentStatus::ACTUAL, { 5 });
+    server.AddDocument(3, "groomed starling cat"s, DocumentStatus::REMOVED, { 9 });
+    server.AddDocument(41, "cat with fluffy collar"s, DocumentStatus::BANNED, { 1 });
+    server.RemoveDocument(70);
+    server.SaveIndex(path);
+
+    SearchServer loaded_server(""s);
+    loaded_server.LoadIndex(path);
+    remove(path.c_str());
+
+    for (const SearchServer* current_server : { &server, &loaded_server }) {
+        for (const string& query : { "cat"s, "fluffy cat"s }) {
+            const vector<Document> seq_docs = current_server->FindTopDocuments(query, DocumentStatus::BANNED);
+            const vector<Document> par_docs = current_server->FindTopDocuments(execution::par, query, DocumentStatus::BANNED);
+            ASSERT_EQUAL(seq_docs.size(), 2u);
+            ASSERT_EQUAL(par_docs.size(), 2u);
+            for (size_t i = 0; i < seq_docs.size(); ++i) {
+                ASSERT(seq_docs[i].id == 5 || seq_docs[i].id == 41);
+                ASSERT_EQUAL(seq_docs[i].id, par_docs[i].id);
+                ASSERT(EqualFloat(seq_docs[i].relevance, par_docs[i].relevance));
+            }
+        }
+        const vector<Document> actual_docs = current_server->FindTopDocuments("groomed cat"s);
+        ASSERT_EQUAL(actual_docs.size(), 1u);
+        ASSERT_EQUAL(actual_docs[0].id, 1000);
+        ASSERT_EQUAL(current_server->FindTopDocuments("groomed"s, DocumentStatus::REMOVED).size(), 1u);
+    }
+    ASSERT_EQUAL(loaded_server.GetDocumentCount(), 4);
+    AssertExeptionHintNegative([&loaded_server]() { loaded_server.MatchDocument("cat"s, 70); },
+        "Removed document is matched"s);
+}
+void TestPhraseAndProximityQueries() {
+    SearchServer server("and with"s);
+    server.EnablePositionalIndex();
+    server.AddDocument(1, "white cat and fashionable collar"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(2, "fashionable white cat"s, DocumentStatus::ACTUAL, { 2 });
+    server.AddDocument(3, "cat white"s, DocumentStatus::ACTUAL, { 3 });
+    server.AddDocument(4, "collar for a white dog and a cat"s, DocumentStatus::ACTUAL, { 4 });
+
+    const auto find_ids = [](const SearchServer& search_server, const string& query, auto policy) {
+        vector<int> ids;
+        for (const Document& document : search_server.FindTopDocuments(policy, query)) {
+            ids.push_back(document.id);
+        }
+        sort(ids.begin(), ids.end());
+        return ids;
+    };
+
+    const string path = "search_server_positions.bin"s;
+    server.SaveIndex(path);
+    SearchServer loaded_server(""s);
+    loaded_server.LoadIndex(path);
+    remove(path.c_str());
+
+    for (const SearchServer* current_server : { &server, &loaded_server }) {
+        for (const auto& [query, expected_ids] : vector<pair<string, vector<int>>>{
+            { "\"white cat\""s, { 1, 2 } },
+            { "\"cat and fashionable\""s, { 1 } },
+            { "\"white cat\" -collar"s, { 2 } },
+            { "cat NEAR/1 white"s, { 1, 2, 3 } },
+            { "cat NEAR/3 white"s, { 1, 2, 3, 4 } },
+            { "collar \"white dog\" NEAR/2 cat"s, { 4 } } }) {
+            ASSERT(find_ids(*current_server, query, execution::seq) == expected_ids);
+            ASSERT(find_ids(*current_server, query, execution::par) == expected_ids);
+        }
+    }
+
+    ASSERT(get<0>(server.MatchDocument("\"white cat\""s, 3)).empty());
+    ASSERT_EQUAL(get<0>(server.MatchDocument(execution::par, "\"white cat\""s, 2)).size(), 2u);
+    AssertExeptionHintNegative([&server]() { server.FindTopDocuments("\"white cat"s); },
+        "Unclosed phrase is passed"s);
+    AssertExeptionHintNegative([&server]() { server.FindTopDocuments("cat -dog NEAR/2 white"s); },
+        "NEAR after a minus word is passed"s);
+    AssertExeptionHintNegative([&server]() { server.FindTopDocuments("cat and NEAR/2 white"s); },
+        "NEAR after a stop word is passed"s);
+    AssertExeptionHintNegative([&server]() { server.FindTopDocuments("\"and\" NEAR/2 white"s); },
+        "NEAR after an empty phrase is passed"s);
+
+    SearchServer repeat_server(""s);
+    repeat_server.EnablePositionalIndex();
+    repeat_server.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, { 1 });
+    repeat_server.AddDocument(2, "cat dog bird cat"s, DocumentStatus::ACTUAL, { 2 });
+    repeat_server.AddDocument(3, "cat dog cat"s, DocumentStatus::ACTUAL, { 3 });
+    for (const auto& [query, expected_ids] : vector<pair<string, vector<int>>>{
+        { "cat NEAR/2 cat"s, { 3 } },
+        { "cat NEAR/3 cat"s, { 2, 3 } },
+        { "dog NEAR/5 dog"s, {} } }) {
+        ASSERT(find_ids(repeat_server, query, execution::seq) == expected_ids);
+        ASSERT(find_ids(repeat_server, query, execution::par) == expected_ids);
+    }
+    AssertExeptionHintNegative([&server]() { server.EnablePositionalIndex(); },
+        "Positional index is enabled after documents are added"s);
+
+    SearchServer plain_server(""s);
+    plain_server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, { 1 });
+    AssertExeptionHintNegative([&plain_server]() { plain_server.FindTopDocuments("\"white cat\""s); },
+        "Phrase query is passed without positional index"s);
+}
+void TestBm25Scoring() {
+    SearchServer server(""s);
+    server.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(2, "cat cat fish bird"s, DocumentStatus::ACTUAL, { 2 });
+    server.AddDocument(3, "bird"s, DocumentStatus::ACTUAL, { 3 });
+    ASSERT(server.GetScoringModel() == ScoringModel::TF_IDF);
+    server.SetScoringModel(ScoringModel::BM25);
+
+    const double k1 = 1.2;
+    const double b = 0.75;
+    const double average_length = 7.0 / 3.0;
+    const double weight = log((3.0 - 2.0 + 0.5) / (2.0 + 0.5) + 1.0);
+    const auto bm25 = [&](double count, double length) {
+        return weight * count * (k1 + 1.0) / (count + k1 * (1.0 - b + b * length / average_length));
+    };
+
+    for (const auto& found_docs : { server.FindTopDocuments("cat"s), server.FindTopDocuments(execution::par, "cat"s) }) {
+        ASSERT_EQUAL(found_docs.size(), 2u);
+        ASSERT_EQUAL(found_docs[0].id, 2);
+        ASSERT(EqualFloat(found_docs[0].relevance, bm25(2.0, 4.0)));
+        ASSERT_EQUAL(found_docs[1].id, 1);
+        ASSERT(EqualFloat(found_docs[1].relevance, bm25(1.0, 2.0)));
+    }
+
+    server.RemoveDocument(3);
+    const auto found_docs = server.FindTopDocuments("dog fish"s);
+    ASSERT_EQUAL(found_docs.size(), 2u);
+    const double single_weight = log((2.0 - 1.0 + 0.5) / (1.0 + 0.5) + 1.0);
+    const double remaining_average_length = 3.0;
+    ASSERT(EqualFloat(found_docs[0].relevance,
+        single_weight * (k1 + 1.0) / (1.0 + k1 * (1.0 - b + b * 2.0 / remaining_average_length))));
+
+    server.SetScoringModel(ScoringModel::TF_IDF);
+    ASSERT(EqualFloat(server.FindTopDocuments("cat"s)[0].relevance, 0.5 * (log(2.0) - log(2.0))));
+}
+void TestQueryCache() {
+    SearchServer server("and"s);
+    server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(2, "black cat and dog"s, DocumentStatus::BANNED, { 2 });
+    const QueryCache& cache = server.GetQueryCache();
+
+    const auto first_docs = server.FindTopDocuments("cat -bird"s);
+    ASSERT_EQUAL(cache.GetMissCount(), 1u);
+    const auto second_docs = server.FindTopDocuments("-bird  cat cat and"s);
+    ASSERT_EQUAL(cache.GetHitCount(), 1u);
+    ASSERT_EQUAL(second_docs.size(), first_docs.size());
+    ASSERT_EQUAL(second_docs[0].id, 1);
+
+    ASSERT_EQUAL(server.FindTopDocuments("cat -bird"s, DocumentStatus::BANNED)[0].id, 2);
+    ASSERT_EQUAL(server.FindTopDocuments(execution::par, "cat -bird"s).size(), 1u);
+    ASSERT_EQUAL(cache.GetHitCount(), 1u);
+    ASSERT_EQUAL(cache.size(), 3u);
+
+    server.AddDocument(3, "grey cat"s, DocumentStatus::ACTUAL, { 3 });
+    ASSERT_EQUAL(server.FindTopDocuments("cat -bird"s).size(), 2u);
+    ASSERT_EQUAL(cache.size(), 1u);
+    server.RemoveDocument(1);
+    ASSERT_EQUAL(server.FindTopDocuments("cat -bird"s).size(), 1u);
+
+    RequestQueue requests(server);
+    requests.AddFindRequest("grey"s);
+    requests.AddFindRequest("grey"s);
+    ASSERT_EQUAL(cache.GetHitCount(), 2u);
+
+    server.SetQueryCacheCapacity(1);
+    server.FindTopDocuments("cat"s);
+    ASSERT_EQUAL(cache.size(), 1u);
+    server.SetQueryCacheCapacity(0);
+    server.FindTopDocuments("cat"s);
+    server.FindTopDocuments("cat"s);
+    ASSERT_EQUAL(cache.size(), 0u);
+    ASSERT_EQUAL(cache.GetHitCount(), 2u);
+}
+void TestRequestQueueTimeWindow() {
+    SearchServer server(""s);
+    server.AddDocument(1, "curly cat"s, DocumentStatus::ACTUAL, { 1 });
+    RequestQueue requests(server, chrono::minutes(60));
+    ASSERT_EQUAL(requests.AddFindRequest("curly dog"s).size(), 1u);
+    ASSERT_EQUAL(requests.AddFindRequest("sparrow"s).size(), 0u);
+    ASSERT_EQUAL(requests.GetNoResultRequests(), 1);
+
+    const RequestQueue::Clock::time_point start = RequestQueue::Clock::now() + chrono::hours(2);
+    RequestQueue timed_requests(server, chrono::minutes(60));
+    timed_requests.RecordRequest(true, start);
+    timed_requests.RecordRequest(true, start + chrono::minutes(30));
+    timed_requests.RecordRequest(false, start + chrono::minutes(30));
+    ASSERT_EQUAL(timed_requests.GetNoResultRequests(start + chrono::minutes(59)), 2);
+    ASSERT_EQUAL(timed_requests.GetNoResultRequests(start + chrono::minutes(61)), 1);
+    timed_requests.RecordRequest(false, start + chrono::minutes(60));
+    ASSERT_EQUAL(timed_requests.GetNoResultRequests(start + chrono::minutes(60)), 1);
+    ASSERT_EQUAL(timed_requests.GetNoResultRequests(start + chrono::minutes(120)), 0);
+
+    RequestQueue concurrent_requests(server);
+    vector<int> request_numbers(4000);
+    iota(request_numbers.begin(), request_numbers.end(), 0);
+    for_each(execution::par, request_numbers.begin(), request_numbers.end(), [&](int number) {
+        concurrent_requests.AddFindRequest(number % 2 == 0 ? "cat"s : "dog"s);
+    });
+    ASSERT_EQUAL(concurrent_requests.GetNoResultRequests(), 2000);
+}
+void TestAddDocumentsMatchesSequentialIngestion() {
+    mt19937 generator(21);
+    vector<string> texts;
+    for (int i = 0; i < 2000; ++i) {
+        string text;
+        const int word_count = uniform_int_distribution<int>(1, 10)(generator);
+        for (int j = 0; j < word_count; ++j) {
+            text += "word"s + to_string(uniform_int_distribution<int>(0, 60)(generator)) + " "s;
+        }
+        texts.push_back(move(text));
+    }
+
+    SearchServer sequential_server("word0"s);
+    SearchServer batch_server("word0"s);
+    sequential_server.EnablePositionalIndex();
+    batch_server.EnablePositionalIndex();
+    batch_server.AddDocument(5000, "word1 word2"s, DocumentStatus::ACTUAL, { 1 });
+    sequential_server.AddDocument(5000, "word1 word2"s, DocumentStatus::ACTUAL, { 1 });
+    vector<NewDocument> documents;
+    for (int i = 0; i < static_cast<int>(texts.size()); ++i) {
+        const int id = (i * 7919) % 2000;
+        documents.push_back({ id, texts[i], static_cast<DocumentStatus>(id % 3), { i % 7, -i % 5 } });
+        sequential_server.AddDocument(id, texts[i], static_cast<DocumentStatus>(id % 3), { i % 7, -i % 5 });
+    }
+    batch_server.AddDocuments(documents);
+
+    ASSERT_EQUAL(batch_server.GetDocumentCount(), sequential_server.GetDocumentCount());
+    for (int id = 0; id < 2000; id += 97) {
+        const auto& batch_freqs = batch_server.GetWordFrequencies(id);
+        const auto& sequential_freqs = sequential_server.GetWordFrequencies(id);
+        ASSERT_EQUAL(batch_freqs.size(), sequential_freqs.size());
+        for (const auto& [word, freq] : sequential_freqs) {
+            ASSERT(EqualFloat(batch_freqs.at(word), freq));
+        }
+    }
+    for (const string& query : { "word1 word2 -word3"s, "word10 word20 word30 word40"s, "\"word5 word6\" word7"s, "word8 NEAR/2 word9"s }) {
+        for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+            const auto batch_docs = batch_server.FindTopDocuments(query, status, 20);
+            const auto sequential_docs = sequential_server.FindTopDocuments(query, status, 20);
+            ASSERT_EQUAL(batch_docs.size(), sequential_docs.size());
+            for (size_t i = 0; i < batch_docs.size(); ++i) {
+                ASSERT_EQUAL(batch_docs[i].id, sequential_docs[i].id);
+                ASSERT(EqualFloat(batch_docs[i].relevance, sequential_docs[i].relevance));
+                ASSERT_EQUAL(batch_docs[i].rating, sequential_docs[i].rating);
+            }
+        }
+    }
+
+    const vector<NewDocument> duplicated_documents = { { 3000, "word1", DocumentStatus::ACTUAL, {} },
+        { 3001, "word2", DocumentStatus::ACTUAL, {} }, { 3000, "word3", DocumentStatus::ACTUAL, {} } };
+    try {
+        batch_server.AddDocuments(duplicated_documents);
+        ASSERT_HINT(false, "Duplicated ids must be rejected"s);
+    }
+    catch (const invalid_argument&) {
+    }
+    const vector<NewDocument> dirty_documents = { { 3002, "word1", DocumentStatus::ACTUAL, {} },
+        { 3003, "wo\x12rd", DocumentStatus::ACTUAL, {} } };
+    try {
+        batch_server.AddDocuments(dirty_documents);
+        ASSERT_HINT(false, "Dirty documents must be rejected"s);
+    }
+    catch (const invalid_argument&) {
+    }
+    ASSERT_EQUAL(batch_server.GetDocumentCount(), 2001);
+}
+void TestSegmentedSearchServer() {
+    mt19937 generator(5);
+    vector<string> texts;
+    for (int i = 0; i < 600; ++i) {
+        string text;
+        const int word_count = uniform_int_distribution<int>(1, 8)(generator);
+        for (int j = 0; j < word_count; ++j) {
+            text += "word"s + to_string(uniform_int_distribution<int>(0, 30)(generator)) + " "s;
+        }
+        texts.push_back(move(text));
+    }
+    const vector<string> queries = { "word1 word2 -word3"s, "word4"s, "word5 word6 word7 word8"s, "word9 word10 -word11 word12"s };
+
+    for (const ScoringModel scoring_model : { ScoringModel::TF_IDF, ScoringModel::BM25 }) {
+        SearchServer server("word0"s);
+        server.SetScoringModel(scoring_model);
+        SegmentedSearchServer segmented_server("word0"s, scoring_model);
+
+        atomic<bool> is_writing = true;
+        vector<thread> readers;
+        for (int i = 0; i < 3; ++i) {
+            readers.emplace_back([&segmented_server, &queries, &is_writing, i] {
+                while (is_writing) {
+                    ASSERT(segmented_server.FindTopDocuments(queries[i], DocumentStatus::ACTUAL, 7).size() <= 7u);
+                }
+            });
+        }
+        vector<NewDocument> batch;
+        for (int id = 0; id < static_cast<int>(texts.size()); ++id) {
+            server.AddDocument(id, texts[id], static_cast<DocumentStatus>(id % 2), { id % 10 });
+            if (id % 50 < 40) {
+                segmented_server.AddDocument(id, texts[id], static_cast<DocumentStatus>(id % 2), { id % 10 });
+            }
+            else {
+                batch.push_back({ id, texts[id], static_cast<DocumentStatus>(id % 2), { id % 10 } });
+                if (batch.size() == 10) {
+                    segmented_server.AddDocuments(batch);
+                    batch.clear();
+                }
+            }
+        }
+        is_writing = false;
+        for (thread& reader : readers) {
+            reader.join();
+        }
+
+        const auto assert_same_scores = [&server, &segmented_server, &queries]() {
+            ASSERT_EQUAL(segmented_server.GetDocumentCount(), server.GetDocumentCount());
+            for (const string& query : queries) {
+                const auto expected_docs = server.FindTopDocuments(query, DocumentStatus::ACTUAL, 15);
+                const auto found_docs = segmented_server.FindTopDocuments(query, DocumentStatus::ACTUAL, 15);
+                ASSERT_EQUAL(found_docs.size(), expected_docs.size());
+                for (size_t i = 0; i < found_docs.size(); ++i) {
+                    ASSERT(EqualFloat(found_docs[i].relevance, expected_docs[i].relevance));
+                    ASSERT_EQUAL(found_docs[i].rating, expected_docs[i].rating);
+                }
+            }
+        };
+        segmented_server.WaitForMerges();
+        ASSERT(segmented_server.GetSegmentCount() < 20u);
+        assert_same_scores();
+
+        for (int id = 0; id < static_cast<int>(texts.size()); id += 3) {
+            server.RemoveDocument(id);
+            segmented_server.RemoveDocument(id);
+        }
+        ASSERT_EQUAL(segmented_server.GetDocumentCount(), 400);
+        assert_same_scores();
+        for (const string& query : queries) {
+            for (const Document& document : segmented_server.FindTopDocuments(query, DocumentStatus::IRRELEVANT, 50)) {
+                ASSERT(document.id % 3 != 0 && document.id % 2 == 1);
+            }
+        }
+        segmented_server.AddDocument(0, "fresh word4"s, DocumentStatus::ACTUAL, { 100 });
+        segmented_server.WaitForMerges();
+        ASSERT_EQUAL(segmented_server.FindTopDocuments("fresh"s)[0].rating, 100);
+        try {
+            segmented_server.AddDocument(1, "word1"s, DocumentStatus::ACTUAL, { 1 });
+            ASSERT_HINT(false, "Existing ids must be rejected"s);
+        }
+        catch (const invalid_argument&) {
+        }
+    }
+}
+void TestRcuSearchServer() {
+    RcuSearchServer server("and"s);
+    atomic<bool> is_writing = true;
+    vector<thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&server, &is_writing] {
+            size_t seen_count = 0;
+            while (is_writing) {
+                const size_t count = server.FindTopDocuments("common"s, DocumentStatus::ACTUAL, 1000).size();
+                ASSERT(count >= seen_count);
+                seen_count = count;
+            }
+        });
+    }
+    for (int id = 0; id < 300; ++id) {
+        server.AddDocument(id, "common word"s + to_string(id), DocumentStatus::ACTUAL, { id });
+    }
+    is_writing = false;
+    for (thread& reader : readers) {
+        reader.join();
+    }
+    ASSERT_EQUAL(server.GetEpoch(), 300u);
+
+    try {
+        server.AddDocument(1, "common"s, DocumentStatus::ACTUAL, { 1 });
+        ASSERT_HINT(false, "Existing ids must be rejected"s);
+    }
+    catch (const invalid_argument&) {
+    }
+    ASSERT_EQUAL(server.GetEpoch(), 300u);
+
+    server.RemoveDocument(299);
+    for (int i = 0; i < 2; ++i) {
+        const auto found_docs = server.FindTopDocuments("common word298 word299"s);
+        ASSERT_EQUAL(found_docs[0].id, 298);
+        ASSERT_EQUAL(server.FindTopDocuments("common"s, DocumentStatus::ACTUAL, 1000).size(), 299u);
+        server.AddDocument(1000 + i, "other"s, DocumentStatus::ACTUAL, {});
+    }
+
+    // The query caches are the only locks on the search path, and readers never
+    // touch them in either replica.
+    for (int i = 0; i < 2; ++i) {
+        ASSERT_EQUAL(server.Read([](const SearchServer& view) {
+            return view.GetQueryCache().GetHitCount() + view.GetQueryCache().GetMissCount();
+        }), 0u);
+        server.Update([](SearchServer&) {});
+    }
+}
+void TestTokenizerKernels() {
+    const auto split_reference = [](string_view text) {
+        vector<string_view> words;
+        size_t word_begin = text.find_first_not_of(' ');
+        while (word_begin != text.npos) {
+            const size_t word_end = text.find(' ', word_begin);
+            words.push_back(text.substr(word_begin, word_end == text.npos ? text.npos : word_end - word_begin));
+            word_begin = text.find_first_not_of(' ', word_end);
+        }
+        return words;
+    };
+
+    mt19937 generator(3);
+    const string alphabet = "ab  -\t\x01\x1f\x7f\x80\xff"s;
+    vector<string> texts = { ""s, " "s, "a"s, string(32, 'a'), string(32, ' ') + "b"s };
+    for (int i = 0; i < 500; ++i) {
+        string text(uniform_int_distribution<size_t>(0, 130)(generator), ' ');
+        const size_t clean_limit = i % 2 == 0 ? 4 : alphabet.size();
+        for (char& c : text) {
+            c = alphabet[uniform_int_distribution<size_t>(0, clean_limit - 1)(generator)];
+        }
+        texts.push_back(move(text));
+    }
+
+    const TokenizerKernel selected_kernel = GetTokenizerKernel();
+    ASSERT(SetTokenizerKernel(TokenizerKernel::SCALAR));
+    for (const TokenizerKernel kernel : { TokenizerKernel::SCALAR, TokenizerKernel::SSE2, TokenizerKernel::AVX2 }) {
+        if (!SetTokenizerKernel(kernel)) {
+            continue;
+        }
+        for (const string& text : texts) {
+            const bool has_spec_symbols = any_of(text.begin(), text.end(), [](char c) {
+                return static_cast<unsigned char>(c) < ' ';
+            });
+            ASSERT(SplitIntoWords(text) == split_reference(text));
+            ASSERT_EQUAL(ContainsSpecSymbols(text), has_spec_symbols);
+            const auto clean_words = SplitIntoCleanWords(text);
+            ASSERT_EQUAL(clean_words.has_value(), !has_spec_symbols);
+            ASSERT(!clean_words || *clean_words == split_reference(text));
+        }
+    }
+    SetTokenizerKernel(selected_kernel);
+}
+void TestQueryContext() {
+    SearchServer server("and with"s);
+    server.EnablePositionalIndex();
+    server.SetQueryCacheCapacity(0);
+    server.AddDocument(1, "white cat and fashionable collar"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(2, "fashionable white cat"s, DocumentStatus::ACTUAL, { 2 });
+    server.AddDocument(3, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 3 });
+    server.AddDocument(4, "collar for a white dog and a cat"s, DocumentStatus::BANNED, { 4 });
+
+    const vector<pair<string, vector<int>>> queries = {
+        { "fluffy white cat -collar"s, { 3, 2 } },
+        { "cat"s, { 3, 2, 1 } },
+        { "\"white cat\" NEAR/2 fashionable"s, { 2, 1 } } };
+    const auto run_queries = [&server, &queries]() {
+        for (const auto& [query, expected_ids] : queries) {
+            vector<int> ids;
+            for (const Document& document : server.FindTopDocuments(execution::seq, query)) {
+                ids.push_back(document.id);
+            }
+            ASSERT(ids == expected_ids);
+        }
+    };
+
+    QueryContext& context = QueryContext::GetForThread();
+    run_queries();
+    context.ResetStatistics();
+    for (int i = 0; i < 10; ++i) {
+        run_queries();
+    }
+    const QueryContext::Statistics statistics = context.GetStatistics();
+    ASSERT_EQUAL(statistics.query_count, 10 * queries.size());
+    ASSERT(statistics.allocation_count > 0);
+    ASSERT_EQUAL(statistics.arena_overflow_count, 0u);
+
+    {
+        const QueryScope outer_scope;
+        const QueryScope inner_scope;
+        ASSERT(inner_scope.GetResource() == outer_scope.GetResource());
+        server.FindTopDocuments("cat"s);
+    }
+    ASSERT_EQUAL(context.GetStatistics().query_count, 10 * queries.size() + 1);
+
+    string huge_query;
+    for (int i = 0; i < 60000; ++i) {
+        huge_query += "w"s + to_string(i) + " "s;
+    }
+    for (int i = 0; i < 2; ++i) {
+        ASSERT(server.FindTopDocuments(huge_query).empty());
+        ASSERT_EQUAL(context.GetBufferSize(), size_t{ QueryContext::MAX_BUFFER_SIZE });
+    }
+    ASSERT(context.GetStatistics().arena_overflow_count > 0);
+    for (uint64_t i = 0; i < 2 * QueryContext::SHRINK_WINDOW; ++i) {
+        server.FindTopDocuments("cat"s);
+    }
+    ASSERT(context.GetBufferSize() < QueryContext::MAX_BUFFER_SIZE);
+}
+void TestCopiedServerOutlivesOriginal() {
+    optional<SearchServer> original(in_place, "and"s);
+    original->EnablePositionalIndex();
+    original->AddDocument(1, "fluffy cat and fluffy tail"s, DocumentStatus::ACTUAL, { 1 });
+    original->AddDocument(2, "groomed dog"s, DocumentStatus::ACTUAL, { 2 });
+    SearchServer copied_server = *original;
+    SearchServer assigned_server(""s);
+    assigned_server = *original;
+    original.reset();
+
+    for (SearchServer* server : { &copied_server, &assigned_server }) {
+        const vector<Document> found_docs = server->FindTopDocuments("fluffy groomed cat"s);
+        ASSERT_EQUAL(found_docs.size(), 2u);
+        ASSERT_EQUAL(found_docs[0].id, 1);
+        ASSERT_EQUAL(server->FindTopDocuments("\"fluffy cat\""s).size(), 1u);
+        ASSERT(EqualFloat(server->GetWordFrequencies(1).at("fluffy"sv), 0.5));
+        ASSERT_EQUAL(get<0>(server->MatchDocument("cat dog"s, 1)).size(), 1u);
+        server->RemoveDocument(1);
+        ASSERT(server->FindTopDocuments("fluffy cat"s).empty());
+        server->AddDocument(3, "fluffy dog"s, DocumentStatus::ACTUAL, { 3 });
+        ASSERT_EQUAL(server->FindTopDocuments("fluffy dog"s).size(), 2u);
+    }
+}
+void TestCompressedPostingList() {
+    PostingList postings;
+    map<int, pair<uint32_t, uint32_t>> expected;
+    mt19937 generator(7);
+    for (int document_id = 0; document_id < 3000; document_id += 1 + static_cast<int>(generator() % 40)) {
+        const uint32_t term_count = 1 + generator() % 3;
+        const uint32_t document_length = term_count + generator() % 500;
+        postings.Add(document_id, term_count, document_length);
+        expected[document_id] = { term_count, document_length };
+    }
+    for (int i = 0; i < 300; ++i) {
+        const int document_id = static_cast<int>(generator() % 3000);
+        if (generator() % 2) {
+            postings.Add(document_id, 1, 10);
+            auto& [term_count, document_length] = expected.try_emplace(document_id, 0, 10).first->second;
+            ++term_count;
+        }
+        else {
+            ASSERT_EQUAL(postings.Remove(document_id), expected.erase(document_id) == 1);
+        }
+    }
+    ASSERT_EQUAL(postings.size(), expected.size());
+
+    vector<pair<int, double>> decoded;
+    postings.ForEach([&decoded](const RawPosting& posting) {
+        decoded.push_back({ posting.document_id, posting.GetTermFreq() });
+    });
+    ASSERT_EQUAL(decoded.size(), expected.size());
+    auto it = expected.begin();
+    for (const auto& [document_id, term_freq] : decoded) {
+        ASSERT_EQUAL(document_id, it->first);
+        ASSERT(abs(term_freq - static_cast<double>(it->second.first) / it->second.second) < EPSILON);
+        ++it;
+    }
+
+    PostingCursor cursor(postings);
+    for (int document_id = 0; document_id < 3100; document_id += 17) {
+        const bool is_found = cursor.Seek(document_id);
+        ASSERT_EQUAL(is_found, expected.count(document_id) == 1);
+        const auto next = expected.lower_bound(document_id);
+        ASSERT_EQUAL(cursor.IsEnd(), next == expected.end());
+        if (!cursor.IsEnd()) {
+            ASSERT_EQUAL(cursor.GetDocumentId(), next->first);
+            ASSERT(postings.Contains(next->first));
+        }
+    }
+}
 
 void TestStringContaintSpecSymbols() {
     ASSERT(SearchServer::IsNotContainSpecSymbols("Clear String"));
@@ -393,6 +1469,32 @@ void TestSearchServer() {
     RUN_TEST(TestRelevanceCalculation);
     RUN_TEST(TestMatchingDocuments);
     RUN_TEST(TestGettingDocumentCount);
+    RUN_TEST(TestIndexWithUnorderedDocumentIds);
+    RUN_TEST(TestParallelFindTopDocuments);
+    RUN_TEST(TestProcessQueries);
+    RUN_TEST(TestFindTopDocumentsMaxCount);
+    RUN_TEST(TestStringViewQueries);
+    RUN_TEST(TestRemoveDocument);
+    RUN_TEST(TestParallelMatchDocument);
+    RUN_TEST(TestConcurrentMap);
+    RUN_TEST(TestRemoveDuplicates);
+    RUN_TEST(TestSaveAndLoadIndex);
+    RUN_TEST(TestInverseDocumentFreqIsUpdated);
+    RUN_TEST(TestPrunedTopDocumentsMatchExhaustiveSearch);
+    RUN_TEST(TestCompressedPostingList);
+    RUN_TEST(TestDocumentIdSet);
+    RUN_TEST(TestDenseAccumulatorMatchesSparseSearch);
+    RUN_TEST(TestStatusFilterSkipsOtherDocuments);
+    RUN_TEST(TestPhraseAndProximityQueries);
+    RUN_TEST(TestBm25Scoring);
+    RUN_TEST(TestQueryCache);
+    RUN_TEST(TestRequestQueueTimeWindow);
+    RUN_TEST(TestAddDocumentsMatchesSequentialIngestion);
+    RUN_TEST(TestSegmentedSearchServer);
+    RUN_TEST(TestRcuSearchServer);
+    RUN_TEST(TestTokenizerKernels);
+    RUN_TEST(TestQueryContext);
+    RUN_TEST(TestCopiedServerOutlivesOriginal);
 }
 
 void TestSearchServerExeptions() { 
@@ -159,6 +159,32 @@ void TestFilteringByStatus();
 void TestRelevanceCalculation();
 void TestMatchingDocuments();
 void TestGettingDocumentCount();
+void TestIndexWithUnorderedDocumentIds();
+void TestParallelFindTopDocuments();
+void TestProcessQueries();
+void TestFindTopDocumentsMaxCount();
+void TestStringViewQueries();
+void TestRemoveDocument();
+void TestParallelMatchDocument();
+void TestConcurrentMap();
+void TestRemoveDuplicates();
+void TestSaveAndLoadIndex();
+void TestInverseDocumentFreqIsUpdated();
+void TestPrunedTopDocumentsMatchExhaustiveSearch();
+void TestCompressedPostingList();
+void TestDocumentIdSet();
+void TestDenseAccumulatorMatchesSparseSearch();
+void TestStatusFilterSkipsOtherDocuments();
+void TestPhraseAndProximityQueries();
+void TestBm25Scoring();
+void TestQueryCache();
+void TestRequestQueueTimeWindow();
+void TestAddDocumentsMatchesSequentialIngestion();
+void TestSegmentedSearchServer();
+void TestRcuSearchServer();
+void TestTokenizerKernels();
+void TestQueryContext();
+void TestCopiedServerOutlivesOriginal();
 
 //Additive functions tests
 void TestStringContaintSpecSymbols();
@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "segmented_search_server.h"
+
+using namespace std;
+
+namespace {
+
+bool IsMoreRelevant(const Document& lhs, const Document& rhs) {
+    if (abs(lhs.relevance - rhs.relevance) < EPSILON) {
+        return lhs.rating > rhs.rating;
+    }
+    return lhs.relevance > rhs.relevance;
+}
+
+size_t GetSegmentLevel(size_t document_count) {
+    size_t level = 0;
+    for (; document_count >= SegmentedSearchServer::MERGE_FACTOR; document_count /= SegmentedSearchServer::MERGE_FACTOR) {
+        ++level;
+    }
+    return level;
+}
+
+}
+
+SegmentedSearchServer::SegmentedSearchServer(string_view stop_words, ScoringModel scoring_model, bool has_positions)
+    : stop_words_(stop_words)
+    , scoring_model_(scoring_model)
+    , has_positions_(has_positions)
+    , segments_(make_shared<const SegmentSet>()) {
+    SearchServer validated_stop_words(stop_words_);
+    merge_thread_ = thread([this] { RunMerges(); });
+}
+
+SegmentedSearchServer::~SegmentedSearchServer() {
+    {
+        lock_guard guard(write_mutex_);
+        is_stopped_ = true;
+    }
+    merge_condition_.notify_all();
+    merge_thread_.join();
+}
+
+void SegmentedSearchServer::AddDocument(int doc_id, string_view document, DocumentStatus status, const vector<int>& ratings) {
+    const NewDocument new_document{ doc_id, document, status, ratings };
+    AddDocuments({ &new_document, 1 });
+}
+
+void SegmentedSearchServer::AddDocuments(span<const NewDocument> documents) {
+    if (documents.empty()) {
+        return;
+    }
+
+    vector<StoredDocument> stored_documents;
+    stored_documents.reserve(documents.size());
+    for (const NewDocument& document : documents) {
+        stored_documents.push_back({ document.id, string(document.text), document.status, document.ratings });
+    }
+
+    lock_guard guard(write_mutex_);
+    for (const NewDocument& document : documents) {
+        if (document_segments_.count(document.id)) {
+            throw invalid_argument("The dirty document is added");
+        }
+    }
+    Segment segment = BuildSegment(move(stored_documents));
+    for (const NewDocument& document : documents) {
+        document_segments_[document.id] = segment.server.get();
+    }
+
+    SegmentSet segments = *segments_.load();
+    segments.push_back(move(segment));
+    Publish(move(segments));
+}
+
+void SegmentedSearchServer::RemoveDocument(int document_id) {
+    lock_guard guard(write_mutex_);
+    const auto document_it = document_segments_.find(document_id);
+    if (document_it == document_segments_.end()) {
+        return;
+    }
+
+    SegmentSet segments = *segments_.load();
+    for (Segment& segment : segments) {
+        if (segment.server.get() == document_it->second) {
+            auto removed_ids = make_shared<set<int>>(*segment.removed_ids);
+            removed_ids->insert(document_id);
+            segment.removed_ids = move(removed_ids);
+        }
+    }
+    document_segments_.erase(document_it);
+    Publish(move(segments));
+}
+
+vector<Document> SegmentedSearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status, size_t max_count) const {
+    const shared_ptr<const SegmentSet> segments = segments_.load();
+    if (segments->empty()) {
+        return {};
+    }
+
+    // All segments share the stop words, so the query is parsed only once.
+    const QueryScope scope;
+    SearchServer::Query query = segments->front().server->ParseQuery(raw_query, true, scope.GetResource());
+    CollectionStatistics statistics;
+    for (const Segment& segment : *segments) {
+        statistics.Merge(segment.server->GetCollectionStatistics(query, *segment.removed_ids));
+    }
+    query.statistics = &statistics;
+
+    vector<Document> matched_docs;
+    for (const Segment& segment : *segments) {
+        const set<int>& removed_ids = *segment.removed_ids;
+        const vector<Document> segment_docs = segment.server->FindTopDocuments(query,
+            [status, &removed_ids](int document_id, DocumentStatus document_status, int) {
+                return document_status == status && removed_ids.count(document_id) == 0;
+            },
+            max_count);
+        matched_docs.insert(matched_docs.end(), segment_docs.begin(), segment_docs.end());
+    }
+
+    sort(matched_docs.begin(), matched_docs.end(), IsMoreRelevant);
+    if (matched_docs.size() > max_count) {
+        matched_docs.resize(max_count);
+    }
+    return matched_docs;
+}
+
+int SegmentedSearchServer::GetDocumentCount() const {
+    lock_guard guard(write_mutex_);
+    return static_cast<int>(document_segments_.size());
+}
+
+size_t SegmentedSearchServer::GetSegmentCount() const {
+    return segments_.load()->size();
+}
+
+void SegmentedSearchServer::WaitForMerges() {
+    unique_lock lock(write_mutex_);
+    merge_condition_.wait(lock, [this] {
+        return merge_error_ || (!is_merging_ && !FindMergeCandidates(*segments_.load()));
+    });
+    if (merge_error_) {
+        rethrow_exception(merge_error_);
+    }
+}
+
+SegmentedSearchServer::Segment SegmentedSearchServer::BuildSegment(vector<StoredDocument> documents) const {
+    auto server = make_shared<SearchServer>(stop_words_);
+    server->SetScoringModel(scoring_model_);
+    if (has_positions_) {
+        server->EnablePositionalIndex();
+    }
+
+    vector<NewDocument> new_documents;
+    new_documents.reserve(documents.size());
+    for (const StoredDocument& document : documents) {
+        new_documents.push_back({ document.id, document.text, document.status, document.ratings });
+    }
+    server->AddDocuments(new_documents);
+
+    return { move(server), make_shared<const vector<StoredDocument>>(move(documents)), make_shared<const set<int>>() };
+}
+
+void SegmentedSearchServer::Publish(SegmentSet segments) {
+    segments_.store(make_shared<const SegmentSet>(move(segments)));
+    merge_condition_.notify_all();
+}
+
+void SegmentedSearchServer::RunMerges() {
+    unique_lock lock(write_mutex_);
+    while (true) {
+        optional<vector<size_t>> candidates;
+        merge_condition_.wait(lock, [this, &candidates] {
+            candidates = FindMergeCandidates(*segments_.load());
+            return is_stopped_ || candidates;
+        });
+        if (is_stopped_) {
+            return;
+        }
+
+        const shared_ptr<const SegmentSet> merged_segments = segments_.load();
+        is_merging_ = true;
+        lock.unlock();
+
+        try {
+            MergeSegments(lock, *merged_segments, *candidates);
+        }
+        catch (...) {
+            // The published segment set is left as it was; merging stops so the
+            // same candidates are not retried forever.
+            if (!lock.owns_lock()) {
+                lock.lock();
+            }
+            is_merging_ = false;
+            merge_error_ = current_exception();
+            merge_condition_.notify_all();
+            cerr << "Segment merge failed, merging is stopped"s << endl;
+            return;
+        }
+        is_merging_ = false;
+    }
+}
+
+void SegmentedSearchServer::MergeSegments(unique_lock<mutex>& lock, const SegmentSet& merged_segments, const vector<size_t>& candidates) {
+    vector<StoredDocument> documents;
+    for (const size_t index : candidates) {
+        const Segment& segment = merged_segments[index];
+        for (const StoredDocument& document : *segment.documents) {
+            if (segment.removed_ids->count(document.id) == 0) {
+                documents.push_back(document);
+            }
+        }
+    }
+    optional<Segment> merged_segment;
+    if (!documents.empty()) {
+        merged_segment = BuildSegment(move(documents));
+    }
+
+    lock.lock();
+    // Documents removed while the merge was running are still indexed by the
+    // merged segment, so they move to its removed ids.
+    set<int> removed_ids;
+    SegmentSet segments;
+    for (const Segment& segment : *segments_.load()) {
+        const auto merged_it = find_if(candidates.begin(), candidates.end(), [&](size_t index) {
+            return merged_segments[index].server == segment.server;
+        });
+        if (merged_it == candidates.end()) {
+            segments.push_back(segment);
+            continue;
+        }
+        const set<int>& merged_removed_ids = *merged_segments[*merged_it].removed_ids;
+        for (const int id : *segment.removed_ids) {
+            if (merged_removed_ids.count(id) == 0) {
+                removed_ids.insert(id);
+            }
+        }
+    }
+    if (merged_segment) {
+        merged_segment->removed_ids = make_shared<const set<int>>(move(removed_ids));
+        segments.push_back(*merged_segment);
+    }
+    Publish(move(segments));
+
+    // Nothing below throws, so document_segments_ never points at a segment
+    // that failed to be published.
+    if (merged_segment) {
+        for (const StoredDocument& document : *merged_segment->documents) {
+            const auto document_it = document_segments_.find(document.id);
+            if (document_it != document_segments_.end() && merged_segment->removed_ids->count(document.id) == 0) {
+                document_it->second = merged_segment->server.get();
+            }
+        }
+    }
+}
+
+optional<vector<size_t>> SegmentedSearchServer::FindMergeCandidates(const SegmentSet& segments) {
+    map<size_t, vector<size_t>> levels;
+    for (size_t index = 0; index < segments.size(); ++index) {
+        const Segment& segment = segments[index];
+        vector<size_t>& level = levels[GetSegmentLevel(segment.documents->size() - segment.removed_ids->size())];
+        level.push_back(index);
+        if (level.size() == MERGE_FACTOR) {
+            return level;
+        }
+    }
+    return nullopt;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "search_server.h"
+
+// Index split into immutable SearchServer segments. Every write publishes a new
+// segment set and searches pin the set that was current when they started, so
+// writers never block readers. A background thread merges segments of similar
+// size and drops removed documents from them. Scores use the statistics of the
+// live documents of all segments, so results do not depend on how documents
+// are split into segments or on when removed ones are merged away.
+class SegmentedSearchServer {
+public:
+    static const size_t MERGE_FACTOR = 4;
+
+    explicit SegmentedSearchServer(std::string_view stop_words,
+        ScoringModel scoring_model = ScoringModel::TF_IDF,
+        bool has_positions = false);
+    ~SegmentedSearchServer();
+
+    SegmentedSearchServer(const SegmentedSearchServer&) = delete;
+    SegmentedSearchServer& operator=(const SegmentedSearchServer&) = delete;
+
+    void AddDocument(int doc_id,
+        std::string_view document,
+        DocumentStatus status,
+        const std::vector<int>& ratings);
+
+    void AddDocuments(std::span<const NewDocument> documents);
+
+    void RemoveDocument(int document_id);
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query,
+        DocumentStatus status = DocumentStatus::ACTUAL,
+        size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    int GetDocumentCount() const;
+
+    size_t GetSegmentCount() const;
+
+    // Rethrows the exception that stopped the background merges, if any.
+    void WaitForMerges();
+
+private:
+    struct StoredDocument {
+        int id;
+        std::string text;
+        DocumentStatus status;
+        std::vector<int> ratings;
+    };
+
+    struct Segment {
+        std::shared_ptr<const SearchServer> server;
+        std::shared_ptr<const std::vector<StoredDocument>> documents;
+        std::shared_ptr<const std::set<int>> removed_ids;
+    };
+
+    using SegmentSet = std::vector<Segment>;
+
+    const std::string stop_words_;
+    const ScoringModel scoring_model_;
+    const bool has_positions_;
+
+    std::atomic<std::shared_ptr<const SegmentSet>> segments_;
+
+    mutable std::mutex write_mutex_;
+    std::condition_variable merge_condition_;
+    std::map<int, const SearchServer*> document_segments_;
+    bool is_merging_ = false;
+    bool is_stopped_ = false;
+    std::exception_ptr merge_error_;
+    std::thread merge_thread_;
+
+    Segment BuildSegment(std::vector<StoredDocument> documents) const;
+
+    void Publish(SegmentSet segments);
+
+    void RunMerges();
+
+    // Merges the candidate segments and publishes the result. Called without
+    // the write lock held, returns with it held.
+    void MergeSegments(std::unique_lock<std::mutex>& lock, const SegmentSet& merged_segments,
+        const std::vector<size_t>& candidates);
+
+    static std::optional<std::vector<size_t>> FindMergeCandidates(const SegmentSet& segments);
+};
@@ -1,24 +1,235 @@
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
 #include "string_processing.h"
 
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SEARCHER_HAS_X86_SIMD
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SEARCHER_TARGET_AVX2 __attribute__((target("avx2")))
+#define SEARCHER_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define SEARCHER_TARGET_AVX2
+#define SEARCHER_ALWAYS_INLINE __forceinline
+#endif
+
 using namespace std;
 
-vector<string> SplitIntoWords(const string& text) {
-    vector<string> words;
-    string word;
-    for (const char c : text) {
-        if (c == ' ') {
-            if (!word.empty()) {
-                words.push_back(word);
-                word.clear();
+namespace {
+
+const size_t BLOCK_SIZE = 32;
+
+// Bit i is set if byte i of the block is a space or a control character.
+struct BlockMasks {
+    uint32_t spaces;
+    uint32_t spec_symbols;
+};
+
+// Classifiers are function objects of distinct types, so every ScanText
+// instantiation inlines its own kernel.
+struct ClassifyBlockScalar {
+    BlockMasks operator()(const char* block) const {
+        BlockMasks masks{ 0, 0 };
+        for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+            const unsigned char c = static_cast<unsigned char>(block[i]);
+            masks.spaces |= static_cast<uint32_t>(c == ' ') << i;
+            masks.spec_symbols |= static_cast<uint32_t>(c < ' ') << i;
+        }
+        return masks;
+    }
+};
+
+#ifdef SEARCHER_HAS_X86_SIMD
+struct ClassifyBlockSse2 {
+    BlockMasks operator()(const char* block) const {
+        const __m128i spaces = _mm_set1_epi8(' ');
+        const __m128i last_spec_symbol = _mm_set1_epi8(' ' - 1);
+        BlockMasks masks{ 0, 0 };
+        for (int half = 0; half < 2; ++half) {
+            const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * half));
+            const __m128i spec_symbols = _mm_cmpeq_epi8(_mm_min_epu8(chars, last_spec_symbol), chars);
+            masks.spaces |= static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chars, spaces))) << (16 * half);
+            masks.spec_symbols |= static_cast<uint32_t>(_mm_movemask_epi8(spec_symbols)) << (16 * half);
+        }
+        return masks;
+    }
+};
+
+struct ClassifyBlockAvx2 {
+    SEARCHER_TARGET_AVX2 BlockMasks operator()(const char* block) const {
+        const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+        const __m256i spec_symbols = _mm256_cmpeq_epi8(_mm256_min_epu8(chars, _mm256_set1_epi8(' ' - 1)), chars);
+        return {
+            static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8(' ')))),
+            static_cast<uint32_t>(_mm256_movemask_epi8(spec_symbols)),
+        };
+    }
+};
+#endif
+
+bool IsKernelSupported(TokenizerKernel kernel) {
+    switch (kernel) {
+    case TokenizerKernel::SCALAR:
+        return true;
+#if defined(SEARCHER_HAS_X86_SIMD)
+    case TokenizerKernel::SSE2:
+        return true;
+    case TokenizerKernel::AVX2:
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_cpu_supports("avx2");
+#else
+    {
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) {
+            return false;
+        }
+        __cpuid(info, 1);
+        const int osxsave_and_avx = (1 << 27) | (1 << 28);
+        if ((info[2] & osxsave_and_avx) != osxsave_and_avx || (_xgetbv(0) & 6) != 6) {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }
+#endif
+#endif
+    default:
+        return false;
+    }
+}
+
+atomic<TokenizerKernel>& GetSelectedKernel() {
+    static atomic<TokenizerKernel> kernel = IsKernelSupported(TokenizerKernel::AVX2) ? TokenizerKernel::AVX2
+        : IsKernelSupported(TokenizerKernel::SSE2) ? TokenizerKernel::SSE2
+        : TokenizerKernel::SCALAR;
+    return kernel;
+}
+
+// Words start and end where the space mask changes, so each block is handled
+// with bit operations instead of a per-byte loop. The last partial block is
+// padded with spaces. Without an output vector the scan stops at the first
+// control character. The loop is inlined into each kernel's entry point, so
+// it is compiled for that kernel's instruction set.
+template <typename ClassifyBlock, typename Words>
+SEARCHER_ALWAYS_INLINE bool ScanBlocks(string_view text, Words* words) {
+    const ClassifyBlock classify_block{};
+    uint32_t spec_symbols = 0;
+    uint32_t previous_space = 1;
+    bool is_in_word = false;
+    size_t word_begin = 0;
+    char tail[BLOCK_SIZE];
+    for (size_t offset = 0; offset < text.size(); offset += BLOCK_SIZE) {
+        const char* block = text.data() + offset;
+        if (text.size() - offset < BLOCK_SIZE) {
+            memset(tail, ' ', BLOCK_SIZE);
+            memcpy(tail, block, text.size() - offset);
+            block = tail;
+        }
+        const BlockMasks masks = classify_block(block);
+        spec_symbols |= masks.spec_symbols;
+        if (words == nullptr) {
+            if (spec_symbols != 0) {
+                return true;
             }
+            continue;
         }
-        else {
-            word += c;
+
+        uint32_t boundaries = masks.spaces ^ ((masks.spaces << 1) | previous_space);
+        previous_space = masks.spaces >> (BLOCK_SIZE - 1);
+        while (boundaries != 0) {
+            const size_t position = offset + countr_zero(boundaries);
+            boundaries &= boundaries - 1;
+            if (is_in_word) {
+                words->push_back(text.substr(word_begin, position - word_begin));
+            }
+            else {
+                word_begin = position;
+            }
+            is_in_word = !is_in_word;
         }
     }
-    if (!word.empty()) {
-        words.push_back(word);
+    if (is_in_word) {
+        words->push_back(text.substr(word_begin));
+    }
+    return spec_symbols != 0;
+}
+
+template <typename Words>
+bool ScanTextScalar(string_view text, Words* words) {
+    return ScanBlocks<ClassifyBlockScalar>(text, words);
+}
+
+#ifdef SEARCHER_HAS_X86_SIMD
+template <typename Words>
+bool ScanTextSse2(string_view text, Words* words) {
+    return ScanBlocks<ClassifyBlockSse2>(text, words);
+}
+
+template <typename Words>
+SEARCHER_TARGET_AVX2 bool ScanTextAvx2(string_view text, Words* words) {
+    return ScanBlocks<ClassifyBlockAvx2>(text, words);
+}
+#endif
+
+template <typename Words>
+bool ScanText(string_view text, Words* words) {
+    switch (GetSelectedKernel().load(memory_order_relaxed)) {
+#ifdef SEARCHER_HAS_X86_SIMD
+    case TokenizerKernel::AVX2:
+        return ScanTextAvx2(text, words);
+    case TokenizerKernel::SSE2:
+        return ScanTextSse2(text, words);
+#endif
+    default:
+        return ScanTextScalar(text, words);
+    }
+}
+
+}
+
+TokenizerKernel GetTokenizerKernel() {
+    return GetSelectedKernel().load();
+}
+
+bool SetTokenizerKernel(TokenizerKernel kernel) {
+    if (!IsKernelSupported(kernel)) {
+        return false;
+    }
+    GetSelectedKernel().store(kernel);
+    return true;
+}
+
+vector<string_view> SplitIntoWords(string_view text) {
+    vector<string_view> words;
+    ScanText(text, &words);
+    return words;
+}
+
+optional<vector<string_view>> SplitIntoCleanWords(string_view text) {
+    vector<string_view> words;
+    if (ScanText(text, &words)) {
+        return nullopt;
     }
+    return words;
+}
 
+optional<pmr::vector<string_view>> SplitIntoCleanWords(string_view text, pmr::memory_resource* resource) {
+    pmr::vector<string_view> words(resource);
+    if (ScanText(text, &words)) {
+        return nullopt;
+    }
     return words;
-}
\ No newline at end of file
+}
+
+bool ContainsSpecSymbols(string_view text) {
+    return ScanText(text, static_cast<vector<string_view>*>(nullptr));
+}
@@ -1,5 +1,28 @@
 #pragma once
+#include <memory_resource>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
-std::vector<std::string> SplitIntoWords(const std::string& text);
\ No newline at end of file
+// Text is scanned in 32-byte blocks. The kernel is chosen from the features of
+// the running CPU on first use; SetTokenizerKernel returns false if the CPU
+// does not support the requested one.
+enum class TokenizerKernel {
+    SCALAR,
+    SSE2,
+    AVX2,
+};
+
+TokenizerKernel GetTokenizerKernel();
+bool SetTokenizerKernel(TokenizerKernel kernel);
+
+std::vector<std::string_view> SplitIntoWords(std::string_view text);
+
+// Splits text and checks it for control characters in the same pass; returns
+// nullopt if there are any.
+std::optional<std::vector<std::string_view>> SplitIntoCleanWords(std::string_view text);
+std::optional<std::pmr::vector<std::string_view>> SplitIntoCleanWords(std::string_view text,
+    std::pmr::memory_resource* resource);
+
+bool ContainsSpecSymbols(std::string_view text);